@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "MBOParsed.hpp"
+
+// DBN record type for market-by-order messages
+constexpr uint8_t kDbnRTypeMbo = 0xA0;
+
+// DBN MBO record exactly as laid out in the file (all DBN versions)
+struct DbnMboMsg {
+    uint8_t  length;        // record length in 4 byte words
+    uint8_t  rtype;
+    uint16_t publisher_id;
+    uint32_t instrument_id;
+    uint64_t ts_event;
+    uint64_t order_id;
+    int64_t  price;         // fixed-point, 1e-9
+    uint32_t size;
+    uint8_t  flags;
+    uint8_t  channel_id;
+    char     action;
+    char     side;
+    uint64_t ts_recv;
+    int32_t  ts_in_delta;
+    uint32_t sequence;
+};
+
+static_assert(sizeof(DbnMboMsg) == 56, "DbnMboMsg must match the DBN layout");
+
+// Decoded DBN metadata header
+struct DbnMetadata {
+    uint8_t     version = 0;
+    std::string dataset;
+    uint16_t    schema = 0;
+    uint64_t    start = 0;
+    uint64_t    end = 0;
+    uint8_t     stype_in = 0;
+    uint8_t     stype_out = 0;
+    bool        ts_out = false;
+    std::vector<std::string> symbols;
+    // instrument_id -> raw symbol, from the symbol mappings
+    std::unordered_map<uint32_t, std::string> instrument_symbols;
+};
+
+// Memory-mapped reader for Databento DBN files (uncompressed, MBO schema).
+// Records are never copied out of the mapping: iteration hands back
+// references straight into the file.
+class DbnReader {
+public:
+    class Iterator {
+    public:
+        Iterator(const uint8_t* pos, const uint8_t* end) : pos_(pos), end_(end) { skipOther(); }
+
+        const DbnMboMsg& operator*() const { return *reinterpret_cast<const DbnMboMsg*>(pos_); }
+        const DbnMboMsg* operator->() const { return reinterpret_cast<const DbnMboMsg*>(pos_); }
+        Iterator& operator++() { pos_ += recordSize(); skipOther(); return *this; }
+        bool operator!=(const Iterator& other) const { return pos_ != other.pos_; }
+        bool operator==(const Iterator& other) const { return pos_ == other.pos_; }
+
+    private:
+        size_t recordSize() const { return static_cast<size_t>(pos_[0]) * 4; }
+        // Step over non-MBO records and stop at a truncated tail
+        void skipOther();
+
+        const uint8_t* pos_;
+        const uint8_t* end_;
+    };
+
+    DbnReader();
+    ~DbnReader();
+
+    DbnReader(const DbnReader&) = delete;
+    DbnReader& operator=(const DbnReader&) = delete;
+
+    // Map the file and validate its metadata header. populate pre-faults
+    // the whole file; streaming readers skip it so large files open
+    // instantly and are paged in as they are read.
+    bool open(const std::string& path, bool populate = true);
+    void close();
+
+    const DbnMetadata& metadata() const { return metadata_; }
+
+    Iterator begin() const { return Iterator(records_begin_, records_end_); }
+    Iterator end() const { return Iterator(records_end_, records_end_); }
+
+    // Fill an MBOParsed from a raw record, resolving the symbol from the
+    // metadata symbol mappings
+    void toParsed(const DbnMboMsg& msg, MBOParsed& record) const;
+
+private:
+    bool parseMetadata(const uint8_t* data, size_t size);
+
+    int fd_;
+    void* map_;
+    size_t map_size_;
+    const uint8_t* records_begin_;
+    const uint8_t* records_end_;
+    DbnMetadata metadata_;
+
+    // Last symbol lookup, records of one instrument come in long runs
+    mutable uint32_t cached_instrument_;
+    mutable char cached_symbol_[kSymbolLen];
+};
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// What FaultInjector does to a stream (all off by default)
+struct FaultConfig {
+    double drop = 0.0;          // chance a sample is lost
+    double reorder = 0.0;       // chance a sample is held back...
+    unsigned reorder_depth = 8; // ...behind up to this many later ones
+    uint64_t seed = 1;
+
+    bool enabled() const { return drop > 0.0 || reorder > 0.0; }
+
+    // "drop:P,reorder:P,depth:N,seed:S", any subset in any order.
+    // False (out unchanged) if malformed.
+    static bool parse(const std::string& spec, FaultConfig& out) {
+        FaultConfig config = out;
+        size_t pos = 0;
+        while (pos <= spec.size()) {
+            size_t comma = spec.find(',', pos);
+            if (comma == std::string::npos) {
+                comma = spec.size();
+            }
+            const std::string item = spec.substr(pos, comma - pos);
+            const size_t colon = item.find(':');
+            if (colon == std::string::npos || colon + 1 == item.size()) {
+                return false;
+            }
+            const std::string key = item.substr(0, colon);
+            const std::string value = item.substr(colon + 1);
+            size_t used = 0;
+            try {
+                if (key == "drop") {
+                    config.drop = std::stod(value, &used);
+                } else if (key == "reorder") {
+                    config.reorder = std::stod(value, &used);
+                } else if (key == "depth") {
+                    config.reorder_depth = static_cast<unsigned>(std::stoul(value, &used));
+                } else if (key == "seed") {
+                    config.seed = std::stoull(value, &used);
+                } else {
+                    return false;
+                }
+            } catch (const std::exception&) {
+                return false;
+            }
+            if (used != value.size()) {
+                return false;
+            }
+            pos = comma + 1;
+        }
+        if (config.drop < 0.0 || config.reorder < 0.0 || config.drop + config.reorder > 1.0 ||
+            config.reorder_depth == 0) {
+            return false;
+        }
+        out = config;
+        return true;
+    }
+};
+
+// Test aid standing between a sender and its transport: loses and
+// reorders samples at the configured rates, reproducibly for a seed.
+template <typename T>
+class FaultInjector {
+public:
+    explicit FaultInjector(const FaultConfig& config)
+        : config_(config), rng_(config.seed), dropped_(0), reordered_(0) {
+    }
+
+    // Pass sample on: send(const T&) is called for everything that goes
+    // out now, which may be nothing, sample itself, and/or samples held
+    // back earlier
+    template <typename Send>
+    void push(const T& sample, Send&& send) {
+        const double roll = uniform_(rng_);
+        if (roll < config_.drop) {
+            ++dropped_;
+        } else if (roll < config_.drop + config_.reorder) {
+            ++reordered_;
+            held_.push_back({sample, 1 + static_cast<unsigned>(rng_() % config_.reorder_depth)});
+            return;
+        } else {
+            send(sample);
+        }
+        release(send);
+    }
+
+    // Send everything still held back
+    template <typename Send>
+    void flush(Send&& send) {
+        for (const Held& held : held_) {
+            send(held.sample);
+        }
+        held_.clear();
+    }
+
+    uint64_t dropped() const { return dropped_; }
+    uint64_t reordered() const { return reordered_; }
+
+private:
+    struct Held {
+        T sample;
+        unsigned remaining;     // samples still to pass it
+    };
+
+    template <typename Send>
+    void release(Send& send) {
+        size_t kept = 0;
+        for (size_t i = 0; i < held_.size(); ++i) {
+            if (--held_[i].remaining == 0) {
+                send(held_[i].sample);
+            } else {
+                held_[kept++] = held_[i];
+            }
+        }
+        held_.resize(kept);
+    }
+
+    FaultConfig config_;
+    std::mt19937_64 rng_;
+    std::uniform_real_distribution<double> uniform_;
+    std::vector<Held> held_;
+    uint64_t dropped_;
+    uint64_t reordered_;
+};
@@ -0,0 +1,177 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Log-linear histogram of nanosecond values, HDR style: every power of two
+// is split into 32 linear sub-buckets, so any recorded value is known to
+// within ~3% over the full uint64_t range. Fixed size, no allocation;
+// record() is a few instructions.
+class LatencyHistogram {
+    friend class SharedLatencyHistogram;
+
+public:
+    static constexpr unsigned kSubBits = 5;
+    static constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBits;
+    static constexpr size_t kBuckets = (64 - kSubBits + 1) * kSubBuckets;
+
+    LatencyHistogram() { reset(); }
+
+    void reset() {
+        counts_.fill(0);
+        count_ = 0;
+        sum_ = 0;
+        min_ = UINT64_MAX;
+        max_ = 0;
+    }
+
+    void record(uint64_t value) {
+        ++counts_[bucketOf(value)];
+        ++count_;
+        sum_ += value;
+        if (value < min_) min_ = value;
+        if (value > max_) max_ = value;
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < kBuckets; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        if (other.min_ < min_) min_ = other.min_;
+        if (other.max_ > max_) max_ = other.max_;
+    }
+
+    // Keep only the samples recorded since earlier, an older copy of this
+    // histogram. Exact min and max of those aren't known; they become the
+    // bounds of the lowest and highest buckets left.
+    void subtract(const LatencyHistogram& earlier) {
+        min_ = UINT64_MAX;
+        max_ = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            counts_[i] -= earlier.counts_[i];
+            if (counts_[i] != 0) {
+                if (min_ == UINT64_MAX) min_ = i == 0 ? 0 : bucketTop(i - 1) + 1;
+                max_ = bucketTop(i);
+            }
+        }
+        count_ -= earlier.count_;
+        sum_ -= earlier.sum_;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t min() const { return count_ ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ ? double(sum_) / double(count_) : 0.0; }
+
+    // Value at or below which fraction q (0..1) of the samples fall; the
+    // top of its bucket, capped at the largest value seen
+    uint64_t percentile(double q) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(q * double(count_) + 0.5);
+        if (rank == 0) rank = 1;
+        if (rank > count_) rank = count_;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                const uint64_t top = bucketTop(i);
+                return top < max_ ? top : max_;
+            }
+        }
+        return max_;
+    }
+
+private:
+    static size_t bucketOf(uint64_t value) {
+        if (value < kSubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        const unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        const unsigned shift = msb - kSubBits;
+        return static_cast<size_t>((shift + 1) * kSubBuckets + (value >> shift) - kSubBuckets);
+    }
+
+    // Largest value that lands in bucket i
+    static uint64_t bucketTop(size_t i) {
+        if (i < kSubBuckets) {
+            return i;
+        }
+        const unsigned shift = static_cast<unsigned>(i / kSubBuckets) - 1;
+        const uint64_t mantissa = i % kSubBuckets + kSubBuckets;
+        if (shift + kSubBits + 1 >= 64 && mantissa + 1 == 2 * kSubBuckets) {
+            return UINT64_MAX;
+        }
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    std::array<uint64_t, kBuckets> counts_;
+    uint64_t count_;
+    uint64_t sum_;
+    uint64_t min_;
+    uint64_t max_;
+};
+
+// A LatencyHistogram one thread records into while others read it, for
+// live stats. Every field is an atomic the writer updates with a relaxed
+// load and store (no read-modify-write), so record() costs about what the
+// plain one does. A snapshot may miss the last few samples or catch one
+// half recorded; fine for monitoring.
+class SharedLatencyHistogram {
+public:
+    SharedLatencyHistogram() {
+        for (auto& count : counts_) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        min_.store(UINT64_MAX, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    // Writer thread only
+    void record(uint64_t value) {
+        bump(counts_[LatencyHistogram::bucketOf(value)], 1);
+        bump(count_, 1);
+        bump(sum_, value);
+        if (value < min_.load(std::memory_order_relaxed)) min_.store(value, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed)) max_.store(value, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+    // Any thread: copy the samples so far into out
+    void snapshot(LatencyHistogram& out) const {
+        for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i) {
+            out.counts_[i] = counts_[i].load(std::memory_order_relaxed);
+        }
+        out.count_ = count_.load(std::memory_order_relaxed);
+        out.sum_ = sum_.load(std::memory_order_relaxed);
+        out.min_ = min_.load(std::memory_order_relaxed);
+        out.max_ = max_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static void bump(std::atomic<uint64_t>& field, uint64_t by) {
+        field.store(field.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, LatencyHistogram::kBuckets> counts_;
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> min_;
+    std::atomic<uint64_t> max_;
+};
+
+// "p50 N, p99 N, p99.9 N, max N ns (N samples)"
+inline void printPercentiles(std::ostream& out, const LatencyHistogram& histogram) {
+    out << "p50 " << histogram.percentile(0.50) << ", p99 " << histogram.percentile(0.99)
+        << ", p99.9 " << histogram.percentile(0.999) << ", max " << histogram.max() << " ns ("
+        << histogram.count() << " samples)";
+}
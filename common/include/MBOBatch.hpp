@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "MBOWire.hpp"
+
+// Topic batched publishers write to (MBOBatchType)
+constexpr const char* kBatchTopicName = "MBOBatchTopic";
+
+// Most records one batch sample can carry
+constexpr size_t kMaxBatchRecords = 64;
+
+// Up to kMaxBatchRecords consecutive records of one instrument in a single
+// DDS sample, so the per-sample RTPS, history and reliability cost is paid
+// once per batch instead of once per record. The header is padded to a
+// cache line so the records keep their alignment.
+#pragma pack(push, 1)
+struct MBOBatchHeader {
+    uint32_t first_sequence;    // feed_sequence of records[0]
+    uint32_t count;             // records in use
+    uint32_t instrument_id;     // every record in the batch is for this instrument
+    char     symbol[kSymbolLen];
+    uint8_t  reserved[64 - 12 - kSymbolLen];
+};
+
+struct MBOBatch {
+    MBOBatchHeader header;
+    MBOWire records[kMaxBatchRecords];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(MBOBatchHeader) == 64, "MBOBatchHeader must stay one cache line");
+
+// Bytes of a batch holding count records, as it goes on the wire
+constexpr size_t batchWireSize(size_t count) {
+    return sizeof(MBOBatchHeader) + count * sizeof(MBOWire);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <fastdds/dds/topic/TopicDataType.hpp>
+#include "MBOBatch.hpp"
+
+// FastDDS topic type carrying one MBOBatch. Like MBOWireType it is plain
+// (loanable, data-sharing capable) and keyed on instrument_id; over a
+// transport only the header and the records in use are serialised.
+class MBOBatchType : public eprosima::fastdds::dds::TopicDataType {
+public:
+    MBOBatchType();
+
+    bool serialize(void* data, eprosima::fastrtps::rtps::SerializedPayload_t* payload) override;
+    bool deserialize(eprosima::fastrtps::rtps::SerializedPayload_t* payload, void* data) override;
+    std::function<uint32_t()> getSerializedSizeProvider(void* data) override;
+
+    void* createData() override;
+    void deleteData(void* data) override;
+
+    bool getKey(void* data, eprosima::fastrtps::rtps::InstanceHandle_t* handle, bool force_md5) override;
+
+    bool is_bounded() const override { return true; }
+    bool is_plain() const override { return true; }
+    bool construct_sample(void* memory) const override;
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <fastdds/dds/topic/IContentFilter.hpp>
+#include <fastdds/dds/topic/IContentFilterFactory.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MBOBatch.hpp"
+#include "MBOWire.hpp"
+
+// Filter class name both participants register, so FastDDS can drop
+// unwanted instruments on the writer side before they hit the network
+constexpr const char* kInstrumentFilterClass = "MBO_INSTRUMENT";
+
+// Content filter over MBOWire or MBOBatch samples. The expression is a
+// comma-separated list of instrument_ids and/or symbols ("432669,CLZ5"); a
+// sample passes when either field matches an entry. It reads the two
+// fields straight out of the serialized payload, which is the raw record
+// (or batch header).
+class MBOInstrumentFilter : public eprosima::fastdds::dds::IContentFilter {
+public:
+    // Where instrument_id and symbol sit in the payload; defaults to MBOWire
+    MBOInstrumentFilter(size_t instrument_offset = offsetof(MBOWire, instrument_id),
+                        size_t symbol_offset = offsetof(MBOWire, symbol),
+                        size_t min_length = sizeof(MBOWire));
+
+    // Replace the filter's entries; false if the expression has no entries
+    // or a symbol is too long
+    bool parse(const char* expression);
+
+    bool matches(uint32_t instrument_id, const char* symbol) const;
+
+    bool evaluate(const eprosima::fastrtps::rtps::SerializedPayload_t& payload,
+                  const FilterSampleInfo& sample_info,
+                  const GUID_t& reader_guid) const override;
+
+private:
+    size_t instrument_offset_;
+    size_t symbol_offset_;
+    size_t min_length_;
+
+    std::vector<uint32_t> instrument_ids_;
+    std::vector<std::array<char, kSymbolLen>> symbols_;
+};
+
+class MBOInstrumentFilterFactory : public eprosima::fastdds::dds::IContentFilterFactory {
+public:
+    eprosima::fastrtps::types::ReturnCode_t create_content_filter(
+        const char* filter_class_name,
+        const char* type_name,
+        const eprosima::fastdds::dds::TopicDataType* data_type,
+        const char* filter_expression,
+        const ParameterSeq& filter_parameters,
+        eprosima::fastdds::dds::IContentFilter*& filter_instance) override;
+
+    eprosima::fastrtps::types::ReturnCode_t delete_content_filter(
+        const char* filter_class_name,
+        eprosima::fastdds::dds::IContentFilter* filter_instance) override;
+};
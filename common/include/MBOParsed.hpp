@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// Fixed-point price scale (DBN native: 1 unit = 1e-9)
+constexpr int64_t kPriceScale = 1000000000LL;
+
+// Width of the inline symbol; NUL padded, not terminated when full
+constexpr size_t kSymbolLen = 9;
+
+// One MBO record as used inside both services. Trivially copyable and
+// exactly one cache line, so copying it never touches the allocator.
+// The human-readable datetime is derived from ts_event only when printed.
+struct alignas(64) MBOParsed {
+    uint64_t ts_event;      // ns since UNIX epoch
+    uint64_t ts_recv;       // ns since UNIX epoch, 0 if the source lacks it
+    uint64_t order_id;
+    int64_t  price;         // fixed-point, kPriceScale units
+    uint32_t size;
+    uint32_t instrument_id;
+    uint32_t sequence;
+    int32_t  ts_in_delta;
+    uint16_t publisher_id;
+    uint8_t  rtype;
+    uint8_t  channel_id;
+    uint8_t  flags;
+    char     action;
+    char     side;
+    char     symbol[kSymbolLen];
+};
+
+static_assert(std::is_trivially_copyable<MBOParsed>::value, "MBOParsed must be trivially copyable");
+static_assert(sizeof(MBOParsed) == 64, "MBOParsed must fit in one cache line");
+static_assert(alignof(MBOParsed) == 64, "MBOParsed must be cache line aligned");
+
+// Symbol as a std::string (for printing / JSON output only)
+inline std::string symbolString(const MBOParsed& record) {
+    return std::string(record.symbol, strnlen(record.symbol, kSymbolLen));
+}
+
+inline void setSymbol(MBOParsed& record, const char* data, size_t len) {
+    std::memset(record.symbol, 0, kSymbolLen);
+    std::memcpy(record.symbol, data, len < kSymbolLen ? len : kSymbolLen);
+}
+
+// Fixed-point <-> double for text input and output
+inline int64_t toFixedPrice(double price) {
+    return static_cast<int64_t>(price * kPriceScale + (price < 0 ? -0.5 : 0.5));
+}
+
+inline double toDoublePrice(int64_t price) {
+    return static_cast<double>(price) / kPriceScale;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+
+// Topic subscribers send recovery requests on (MBORecoveryType)
+constexpr const char* kRecoveryTopicName = "MBORecoveryTopic";
+
+// A subscriber missed records of one instrument: asks the publisher to
+// resend feed sequences [from_sequence, to_sequence] of a session on the
+// data topic. Records the publisher no longer holds are not resent.
+#pragma pack(push, 1)
+struct MBORecoveryRequest {
+    uint32_t instrument_id;
+    uint32_t feed_session;
+    uint32_t from_sequence;
+    uint32_t to_sequence;       // inclusive
+};
+#pragma pack(pop)
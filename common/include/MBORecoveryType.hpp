@@ -0,0 +1,23 @@
+#pragma once
+#include <fastdds/dds/topic/TopicDataType.hpp>
+#include "MBORecovery.hpp"
+
+// FastDDS topic type carrying one MBORecoveryRequest. Plain and unkeyed:
+// requests are rare and every one of them matters.
+class MBORecoveryType : public eprosima::fastdds::dds::TopicDataType {
+public:
+    MBORecoveryType();
+
+    bool serialize(void* data, eprosima::fastrtps::rtps::SerializedPayload_t* payload) override;
+    bool deserialize(eprosima::fastrtps::rtps::SerializedPayload_t* payload, void* data) override;
+    std::function<uint32_t()> getSerializedSizeProvider(void* data) override;
+
+    void* createData() override;
+    void deleteData(void* data) override;
+
+    bool getKey(void* data, eprosima::fastrtps::rtps::InstanceHandle_t* handle, bool force_md5) override;
+
+    bool is_bounded() const override { return true; }
+    bool is_plain() const override { return true; }
+    bool construct_sample(void* memory) const override;
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "MBOParsed.hpp"
+
+// Binary MBO record exchanged between data_streaming and recon_orderbook.
+// Fields are ordered by size so the packed layout has no holes. It carries
+// every DBN field but ts_recv, plus the publisher's feed fields and send
+// stamp: 72 bytes, so records stay 8-byte aligned in rings and batches.
+#pragma pack(push, 1)
+struct MBOWire {
+    uint64_t ts_event;      // ns since UNIX epoch
+    uint64_t ts_send;       // publisher's monotonicNowNs() as the record went out (0 = not stamped)
+    uint64_t order_id;
+    int64_t  price;         // fixed-point, kPriceScale units
+    uint32_t feed_sequence; // per instrument, contiguous from 1 within a session (0 = unsequenced)
+    uint32_t feed_session;  // changes whenever the publisher restarts its sequences
+    uint32_t size;
+    uint32_t instrument_id;
+    uint32_t sequence;
+    int32_t  ts_in_delta;
+    uint16_t publisher_id;
+    uint8_t  rtype;
+    uint8_t  channel_id;
+    uint8_t  flags;
+    char     action;
+    char     side;
+    char     symbol[kSymbolLen];
+};
+#pragma pack(pop)
+
+// A peer built with another layout sees samples of the wrong length and
+// rejects them
+static_assert(sizeof(MBOWire) == 72, "MBOWire layout changed");
+
+// Conversions between the in-process record and the wire record. The
+// publisher stamps the feed fields and ts_send after toWire(), which
+// leaves them 0; ts_recv doesn't travel.
+MBOWire toWire(const MBOParsed& record);
+MBOParsed fromWire(const MBOWire& wire);
@@ -0,0 +1,29 @@
+#pragma once
+#include <fastdds/dds/topic/TopicDataType.hpp>
+#include "MBOWire.hpp"
+
+// Key hash for an instrument_id; shared by every instrument-keyed type
+void setInstrumentKey(uint32_t instrument_id, eprosima::fastrtps::rtps::InstanceHandle_t* handle);
+
+// FastDDS topic type carrying one MBOWire record.
+// The type is plain and bounded, so on the same host FastDDS can hand out
+// loaned samples (loan_sample / return_loan) backed by data-sharing memory
+// instead of serialising through the transport.
+// Keyed on instrument_id, so each instrument is its own DDS instance.
+class MBOWireType : public eprosima::fastdds::dds::TopicDataType {
+public:
+    MBOWireType();
+
+    bool serialize(void* data, eprosima::fastrtps::rtps::SerializedPayload_t* payload) override;
+    bool deserialize(eprosima::fastrtps::rtps::SerializedPayload_t* payload, void* data) override;
+    std::function<uint32_t()> getSerializedSizeProvider(void* data) override;
+
+    void* createData() override;
+    void deleteData(void* data) override;
+
+    bool getKey(void* data, eprosima::fastrtps::rtps::InstanceHandle_t* handle, bool force_md5) override;
+
+    bool is_bounded() const override { return true; }
+    bool is_plain() const override { return true; }
+    bool construct_sample(void* memory) const override;
+};
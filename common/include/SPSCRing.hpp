@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer thread and one
+// consumer thread. Capacity is rounded up to a power of two. Head and
+// tail sit on their own cache lines, and each side caches the other's
+// index so the common case touches no shared line.
+template <typename T>
+class SPSCRing {
+public:
+    explicit SPSCRing(size_t capacity)
+        : head_(0), tail_cache_(0), tail_(0), head_cache_(0),
+          mask_(roundUpPow2(capacity) - 1), slots_(mask_ + 1) {
+    }
+
+    SPSCRing(const SPSCRing&) = delete;
+    SPSCRing& operator=(const SPSCRing&) = delete;
+
+    // Producer: false if the ring is full
+    bool tryPush(const T& item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: false if the ring is empty
+    bool tryPop(T& out) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return false;
+            }
+        }
+        out = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called while the other side is running
+    size_t size() const {
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t head = head_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    static size_t roundUpPow2(size_t n) {
+        size_t p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    // Consumer side
+    alignas(64) std::atomic<size_t> head_;
+    size_t tail_cache_;
+
+    // Producer side
+    alignas(64) std::atomic<size_t> tail_;
+    size_t head_cache_;
+
+    alignas(64) const size_t mask_;
+    std::vector<T> slots_;
+};
@@ -0,0 +1,180 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include "LatencyHistogram.hpp"
+
+// Segment names the services use unless told otherwise
+constexpr const char* kPublisherStatsName = "data_streaming";
+constexpr const char* kSubscriberStatsName = "recon_orderbook";
+
+constexpr uint32_t kStatsMagic = 0x5453424d;    // "MBST"
+constexpr uint32_t kStatsVersion = 1;
+
+// How often gauges that take a walk over the books are brought up to date
+constexpr uint64_t kStatsRefreshNs = 100000000;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "stats are read from other processes");
+
+// One counter or gauge. Only one thread writes it at a time, with a
+// relaxed load and store (no locked read-modify-write); any thread or
+// process may read it.
+class StatsValue {
+public:
+    void add(uint64_t by = 1) { value_.store(value_.load(std::memory_order_relaxed) + by, std::memory_order_relaxed); }
+    void set(uint64_t value) { value_.store(value, std::memory_order_relaxed); }
+    uint64_t get() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+// Per-action counters: add, cancel, modify, fill, trade, clear, and
+// anything else (not a valid MBO action)
+enum StatsAction : size_t {
+    kStatsAdd, kStatsCancel, kStatsModify, kStatsFill, kStatsTrade, kStatsClear, kStatsOther, kStatsActions
+};
+
+inline size_t statsAction(char action) {
+    switch (action) {
+        case 'A': return kStatsAdd;
+        case 'C': return kStatsCancel;
+        case 'M': return kStatsModify;
+        case 'F': return kStatsFill;
+        case 'T': return kStatsTrade;
+        case 'R': return kStatsClear;
+        default:  return kStatsOther;
+    }
+}
+
+// data_streaming: written by the loader thread (records_in, parse_errors)
+// and the publishing thread
+struct alignas(64) PublisherStats {
+    StatsValue records_in;          // read from the file
+    StatsValue parse_errors;        // malformed CSV lines skipped
+    StatsValue records_out;         // published
+    StatsValue samples_out;         // DDS samples written, resends and heartbeats included
+    StatsValue actions[kStatsActions];
+    StatsValue instruments;
+    StatsValue records_resent;
+    StatsValue recovery_requests;
+    StatsValue recovery_misses;     // records asked for that were no longer held
+};
+
+// recon_orderbook: written by the DDS listener thread
+struct alignas(64) DispatchStats {
+    StatsValue samples_in;          // records taken off the reader
+    StatsValue malformed;           // batches whose header doesn't match their records
+    StatsValue dropped;             // a shard's ring was full
+    SharedLatencyHistogram received;        // since the publisher's ts_send
+};
+
+// recon_orderbook: written by one shard's book thread
+struct alignas(64) ShardStats {
+    StatsValue records;             // applied to a book
+    StatsValue actions[kStatsActions];
+
+    // Gauges, refreshed every kStatsRefreshNs
+    StatsValue books;
+    StatsValue off_tick_prices;     // not on the tick grid, rounded to the nearest tick
+    StatsValue live_orders;
+    StatsValue bid_levels;
+    StatsValue ask_levels;
+    StatsValue ring_depth;
+    StatsValue ring_high_water;
+    StatsValue ring_capacity;
+    StatsValue snapshots_out;
+
+    // Feed sequencing, summed over the shard's instruments
+    StatsValue sessions;
+    StatsValue gaps;
+    StatsValue reordered;           // gaps that filled by themselves
+    StatsValue recovered;           // gaps filled by a resend
+    StatsValue unrecovered;         // gaps skipped
+    StatsValue skipped_records;
+    StatsValue duplicates;
+    StatsValue diverged;            // books that lost records for good
+    StatsValue recovery_requests;
+    StatsValue recovery_dropped;    // found the dispatcher's queue full
+
+    // Out-of-order cancels
+    StatsValue pending_cancels;     // held now
+    StatsValue pending_inserted;
+    StatsValue pending_matched;
+    StatsValue pending_expired;
+    StatsValue pending_evicted;
+
+    StatsValue journal_bytes;
+    StatsValue journal_snapshots;
+    StatsValue journal_stalls;
+
+    // Since the publisher's ts_send
+    SharedLatencyHistogram parsed;
+    SharedLatencyHistogram applied;
+};
+
+enum class StatsService : uint32_t { Publisher = 1, Subscriber = 2 };
+
+struct alignas(64) StatsHeader {
+    std::atomic<uint32_t> magic;    // stored last, once the rest is laid out
+    uint32_t version;
+    StatsService service;
+    uint32_t shards;                // ShardStats blocks after the header
+    uint64_t pid;
+    uint64_t started_ns;            // monotonicNowNs() at creation
+};
+
+// Live counters of one running service in shared memory, at
+// /dev/shm/mbo_stats.NAME: a StatsHeader, then PublisherStats,
+// DispatchStats and one ShardStats per shard. The service's threads
+// write their counters in place as they go, so publishing them costs a
+// store and never blocks or prints; mbo_stat maps the segment read-only
+// and samples it.
+class StatsSegment {
+public:
+    StatsSegment();
+    ~StatsSegment();
+
+    StatsSegment(const StatsSegment&) = delete;
+    StatsSegment& operator=(const StatsSegment&) = delete;
+
+    // Service side: create the segment, replacing any left by an earlier
+    // run. False (with the reason reported) on failure.
+    bool create(const std::string& name, StatsService service, size_t shards);
+
+    // Reader side: map an existing segment read-only. False (with the
+    // reason reported) if it's missing or not a segment this build knows.
+    bool open(const std::string& name);
+
+    // Unmap; the creator also removes the segment
+    void close();
+
+    bool isOpen() const { return base_ != nullptr; }
+
+    const StatsHeader& header() const { return *static_cast<const StatsHeader*>(base_); }
+    PublisherStats& publisher() const { return *at<PublisherStats>(kPublisherOffset); }
+    DispatchStats& dispatch() const { return *at<DispatchStats>(kDispatchOffset); }
+    ShardStats& shard(size_t index) const { return *at<ShardStats>(kShardOffset + index * sizeof(ShardStats)); }
+
+    // "/dev/shm/mbo_stats.NAME"
+    static std::string path(const std::string& name);
+
+    static size_t segmentSize(size_t shards) { return kShardOffset + shards * sizeof(ShardStats); }
+
+private:
+    static constexpr size_t kPublisherOffset = sizeof(StatsHeader);
+    static constexpr size_t kDispatchOffset = kPublisherOffset + sizeof(PublisherStats);
+    static constexpr size_t kShardOffset = kDispatchOffset + sizeof(DispatchStats);
+
+    template <typename Block>
+    Block* at(size_t offset) const {
+        return reinterpret_cast<Block*>(static_cast<char*>(base_) + offset);
+    }
+
+    void* base_;
+    size_t size_;
+    int fd_;                    // kept by the creator, to remove only its own segment
+    std::string name_;
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <ctime>
+
+// Parse an exchange timestamp into nanoseconds since the UNIX epoch.
+// Accepts raw integer nanoseconds or the ISO form pandas writes
+// ("2025-10-19 22:00:00.123456789+00:00"). Returns 0 if unparseable.
+uint64_t parseTimestampNs(const std::string& text);
+
+// Same, from a buffer that need not be NUL terminated
+uint64_t parseTimestampNs(const char* text, size_t size);
+
+// Format nanoseconds since the UNIX epoch as
+// "YYYY-MM-DD HH:MM:SS.nnnnnnnnn+00:00".
+std::string formatTimestampNs(uint64_t ts_ns);
+
+// Same, written into a caller buffer (at least 36 bytes) without
+// allocating. Returns the number of characters written.
+size_t formatTimestampNs(uint64_t ts_ns, char* out, size_t len);
+
+// Host clock for latency stamps, in ns: CLOCK_MONOTONIC_RAW is shared by
+// every process on the host and never slewed or stepped, so a stamp taken
+// in one process can be subtracted from a later one taken in another.
+// Meaningless across hosts.
+inline uint64_t monotonicNowNs() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+}
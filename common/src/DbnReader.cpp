@@ -0,0 +1,276 @@
+#include "DbnReader.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint16_t kDbnSchemaMbo = 0;
+constexpr uint16_t kDbnSchemaMixed = 0xFFFF;
+constexpr uint8_t kDbnSTypeInstrumentId = 0;
+constexpr size_t kDbnPrefixSize = 8;        // "DBN" + version + u32 metadata length
+constexpr size_t kDbnV1SymbolCstrLen = 22;
+
+// Bounds-checked little-endian cursor over the metadata block
+class Cursor {
+public:
+    Cursor(const uint8_t* data, size_t size) : data_(data), size_(size), pos_(0) {}
+
+    template <typename T>
+    bool read(T& out) {
+        if (size_ - pos_ < sizeof(T)) return false;
+        std::memcpy(&out, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool readString(size_t len, std::string& out) {
+        if (size_ - pos_ < len) return false;
+        const char* str = reinterpret_cast<const char*>(data_ + pos_);
+        out.assign(str, strnlen(str, len));
+        pos_ += len;
+        return true;
+    }
+
+    bool skip(size_t len) {
+        if (size_ - pos_ < len) return false;
+        pos_ += len;
+        return true;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_;
+};
+
+bool readSymbolList(Cursor& cur, size_t cstr_len, std::vector<std::string>* out) {
+    uint32_t count;
+    if (!cur.read(count)) return false;
+    std::string symbol;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!cur.readString(cstr_len, symbol)) return false;
+        if (out) out->push_back(symbol);
+    }
+    return true;
+}
+
+} // namespace
+
+void DbnReader::Iterator::skipOther() {
+    while (pos_ < end_) {
+        const size_t remaining = static_cast<size_t>(end_ - pos_);
+        const size_t size = recordSize();
+        if (size == 0 || size > remaining) {
+            // Truncated or corrupt tail: stop iterating
+            pos_ = end_;
+            return;
+        }
+        if (pos_[1] == kDbnRTypeMbo && size >= sizeof(DbnMboMsg)) {
+            return;
+        }
+        pos_ += size;
+    }
+}
+
+DbnReader::DbnReader()
+    : fd_(-1), map_(nullptr), map_size_(0),
+      records_begin_(nullptr), records_end_(nullptr),
+      cached_instrument_(0), cached_symbol_{}
+{
+}
+
+DbnReader::~DbnReader() {
+    close();
+}
+
+void DbnReader::close() {
+    if (map_) {
+        munmap(map_, map_size_);
+        map_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    map_size_ = 0;
+    records_begin_ = records_end_ = nullptr;
+    metadata_ = DbnMetadata();
+    cached_instrument_ = 0;
+}
+
+bool DbnReader::open(const std::string& path, bool populate) {
+    close();
+
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        std::cerr << "Error: Could not open " << path << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || st.st_size < static_cast<off_t>(kDbnPrefixSize)) {
+        std::cerr << "Error: " << path << " is too small to be a DBN file" << std::endl;
+        close();
+        return false;
+    }
+
+    map_size_ = static_cast<size_t>(st.st_size);
+    map_ = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE | (populate ? MAP_POPULATE : 0), fd_, 0);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        std::cerr << "Error: Could not mmap " << path << std::endl;
+        close();
+        return false;
+    }
+    madvise(map_, map_size_, MADV_SEQUENTIAL);
+
+    const uint8_t* data = static_cast<const uint8_t*>(map_);
+    if (data[0] == 0x28 && data[1] == 0xB5 && data[2] == 0x2F && data[3] == 0xFD) {
+        std::cerr << "Error: " << path << " is zstd-compressed, decompress it first (zstd -d)" << std::endl;
+        close();
+        return false;
+    }
+    if (std::memcmp(data, "DBN", 3) != 0) {
+        std::cerr << "Error: " << path << " is not a DBN file" << std::endl;
+        close();
+        return false;
+    }
+
+    if (!parseMetadata(data, map_size_)) {
+        std::cerr << "Error: Invalid DBN metadata in " << path << std::endl;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool DbnReader::parseMetadata(const uint8_t* data, size_t size) {
+    metadata_.version = data[3];
+    if (metadata_.version < 1 || metadata_.version > 3) {
+        std::cerr << "Unsupported DBN version " << int(metadata_.version) << std::endl;
+        return false;
+    }
+
+    uint32_t metadata_len;
+    std::memcpy(&metadata_len, data + 4, sizeof(metadata_len));
+    const size_t records_offset = kDbnPrefixSize + metadata_len;
+    if (records_offset > size) {
+        return false;
+    }
+    // Records are read in place, so they must start 8 byte aligned
+    if (records_offset % alignof(DbnMboMsg) != 0) {
+        std::cerr << "DBN records are not 8 byte aligned" << std::endl;
+        return false;
+    }
+
+    Cursor cur(data + kDbnPrefixSize, metadata_len);
+    uint64_t limit;
+    if (!cur.readString(16, metadata_.dataset) ||
+        !cur.read(metadata_.schema) ||
+        !cur.read(metadata_.start) ||
+        !cur.read(metadata_.end) ||
+        !cur.read(limit)) {
+        return false;
+    }
+
+    if (metadata_.schema != kDbnSchemaMbo && metadata_.schema != kDbnSchemaMixed) {
+        std::cerr << "DBN schema " << metadata_.schema << " is not MBO" << std::endl;
+        return false;
+    }
+
+    uint8_t ts_out;
+    size_t symbol_cstr_len = kDbnV1SymbolCstrLen;
+    if (metadata_.version == 1) {
+        uint64_t record_count;
+        if (!cur.read(record_count) ||
+            !cur.read(metadata_.stype_in) ||
+            !cur.read(metadata_.stype_out) ||
+            !cur.read(ts_out) ||
+            !cur.skip(47)) {
+            return false;
+        }
+    } else {
+        uint16_t cstr_len;
+        if (!cur.read(metadata_.stype_in) ||
+            !cur.read(metadata_.stype_out) ||
+            !cur.read(ts_out) ||
+            !cur.read(cstr_len) ||
+            !cur.skip(53)) {
+            return false;
+        }
+        symbol_cstr_len = cstr_len;
+    }
+    metadata_.ts_out = ts_out != 0;
+
+    uint32_t schema_definition_len;
+    if (!cur.read(schema_definition_len) || !cur.skip(schema_definition_len)) {
+        return false;
+    }
+
+    // symbols, partial, not_found
+    if (!readSymbolList(cur, symbol_cstr_len, &metadata_.symbols) ||
+        !readSymbolList(cur, symbol_cstr_len, nullptr) ||
+        !readSymbolList(cur, symbol_cstr_len, nullptr)) {
+        return false;
+    }
+
+    uint32_t mapping_count;
+    if (!cur.read(mapping_count)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < mapping_count; ++i) {
+        std::string raw_symbol;
+        uint32_t interval_count;
+        if (!cur.readString(symbol_cstr_len, raw_symbol) || !cur.read(interval_count)) {
+            return false;
+        }
+        for (uint32_t j = 0; j < interval_count; ++j) {
+            uint32_t start_date, end_date;
+            std::string mapped;
+            if (!cur.read(start_date) || !cur.read(end_date) ||
+                !cur.readString(symbol_cstr_len, mapped)) {
+                return false;
+            }
+            if (metadata_.stype_out == kDbnSTypeInstrumentId && !mapped.empty()) {
+                metadata_.instrument_symbols[static_cast<uint32_t>(std::stoul(mapped))] = raw_symbol;
+            }
+        }
+    }
+
+    records_begin_ = data + records_offset;
+    records_end_ = data + size;
+    return true;
+}
+
+void DbnReader::toParsed(const DbnMboMsg& msg, MBOParsed& record) const {
+    record.ts_event = msg.ts_event;
+    record.ts_recv = msg.ts_recv;
+    record.order_id = msg.order_id;
+    record.price = msg.price;
+    record.size = msg.size;
+    record.instrument_id = msg.instrument_id;
+    record.sequence = msg.sequence;
+    record.ts_in_delta = msg.ts_in_delta;
+    record.publisher_id = msg.publisher_id;
+    record.rtype = msg.rtype;
+    record.channel_id = msg.channel_id;
+    record.flags = msg.flags;
+    record.action = msg.action;
+    record.side = msg.side;
+
+    if (msg.instrument_id != cached_instrument_) {
+        cached_instrument_ = msg.instrument_id;
+        std::memset(cached_symbol_, 0, kSymbolLen);
+        auto it = metadata_.instrument_symbols.find(msg.instrument_id);
+        if (it != metadata_.instrument_symbols.end()) {
+            std::memcpy(cached_symbol_, it->second.data(), std::min(it->second.size(), kSymbolLen));
+        }
+    }
+    std::memcpy(record.symbol, cached_symbol_, kSymbolLen);
+}
@@ -0,0 +1,64 @@
+#include "MBOBatchType.hpp"
+#include "MBOWireType.hpp"
+#include <cstring>
+#include <new>
+
+MBOBatchType::MBOBatchType() {
+    setName("MBOBatch");
+    m_typeSize = sizeof(MBOBatch);
+    // One instance per instrument, like MBOWire
+    m_isGetKeyDefined = true;
+}
+
+bool MBOBatchType::serialize(void* data, eprosima::fastrtps::rtps::SerializedPayload_t* payload) {
+    const MBOBatch* batch = static_cast<const MBOBatch*>(data);
+    if (batch->header.count > kMaxBatchRecords) {
+        return false;
+    }
+    const size_t length = batchWireSize(batch->header.count);
+    if (payload->max_size < length) {
+        return false;
+    }
+    memcpy(payload->data, batch, length);
+    payload->length = static_cast<uint32_t>(length);
+    return true;
+}
+
+bool MBOBatchType::deserialize(eprosima::fastrtps::rtps::SerializedPayload_t* payload, void* data) {
+    if (payload->length < sizeof(MBOBatchHeader)) {
+        return false;
+    }
+    MBOBatch* batch = static_cast<MBOBatch*>(data);
+    memcpy(&batch->header, payload->data, sizeof(MBOBatchHeader));
+    if (batch->header.count > kMaxBatchRecords || payload->length != batchWireSize(batch->header.count)) {
+        batch->header.count = 0;
+        return false;
+    }
+    memcpy(batch->records, payload->data + sizeof(MBOBatchHeader), batch->header.count * sizeof(MBOWire));
+    return true;
+}
+
+std::function<uint32_t()> MBOBatchType::getSerializedSizeProvider(void* data) {
+    const uint32_t count = static_cast<const MBOBatch*>(data)->header.count;
+    return [count]() -> uint32_t {
+        return static_cast<uint32_t>(batchWireSize(count < kMaxBatchRecords ? count : kMaxBatchRecords));
+    };
+}
+
+void* MBOBatchType::createData() {
+    return new MBOBatch();
+}
+
+void MBOBatchType::deleteData(void* data) {
+    delete static_cast<MBOBatch*>(data);
+}
+
+bool MBOBatchType::getKey(void* data, eprosima::fastrtps::rtps::InstanceHandle_t* handle, bool) {
+    setInstrumentKey(static_cast<const MBOBatch*>(data)->header.instrument_id, handle);
+    return true;
+}
+
+bool MBOBatchType::construct_sample(void* memory) const {
+    new (memory) MBOBatch();
+    return true;
+}
@@ -0,0 +1,123 @@
+#include "MBOInstrumentFilter.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+
+using eprosima::fastrtps::types::ReturnCode_t;
+
+MBOInstrumentFilter::MBOInstrumentFilter(size_t instrument_offset, size_t symbol_offset, size_t min_length)
+    : instrument_offset_(instrument_offset), symbol_offset_(symbol_offset), min_length_(min_length) {
+}
+
+bool MBOInstrumentFilter::parse(const char* expression) {
+    std::vector<uint32_t> instrument_ids;
+    std::vector<std::array<char, kSymbolLen>> symbols;
+
+    const std::string text = expression ? expression : "";
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        size_t first = start;
+        size_t last = end;
+        while (first < last && std::isspace(static_cast<unsigned char>(text[first]))) ++first;
+        while (last > first && std::isspace(static_cast<unsigned char>(text[last - 1]))) --last;
+        const std::string entry = text.substr(first, last - first);
+        start = end + 1;
+
+        if (entry.empty()) {
+            continue;
+        }
+        if (std::all_of(entry.begin(), entry.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); })) {
+            instrument_ids.push_back(static_cast<uint32_t>(std::stoul(entry)));
+            continue;
+        }
+        if (entry.size() > kSymbolLen) {
+            return false;
+        }
+        std::array<char, kSymbolLen> symbol{};
+        std::memcpy(symbol.data(), entry.data(), entry.size());
+        symbols.push_back(symbol);
+    }
+
+    if (instrument_ids.empty() && symbols.empty()) {
+        return false;
+    }
+    instrument_ids_ = std::move(instrument_ids);
+    symbols_ = std::move(symbols);
+    return true;
+}
+
+bool MBOInstrumentFilter::matches(uint32_t instrument_id, const char* symbol) const {
+    for (uint32_t id : instrument_ids_) {
+        if (id == instrument_id) {
+            return true;
+        }
+    }
+    for (const auto& wanted : symbols_) {
+        if (std::memcmp(wanted.data(), symbol, kSymbolLen) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MBOInstrumentFilter::evaluate(const eprosima::fastrtps::rtps::SerializedPayload_t& payload,
+                                   const FilterSampleInfo&, const GUID_t&) const {
+    if (payload.length < min_length_) {
+        return false;
+    }
+    // The records are packed, so the fields may be unaligned in the payload
+    uint32_t instrument_id;
+    std::memcpy(&instrument_id, payload.data + instrument_offset_, sizeof(instrument_id));
+    return matches(instrument_id, reinterpret_cast<const char*>(payload.data + symbol_offset_));
+}
+
+ReturnCode_t MBOInstrumentFilterFactory::create_content_filter(
+    const char* filter_class_name,
+    const char* type_name,
+    const eprosima::fastdds::dds::TopicDataType*,
+    const char* filter_expression,
+    const ParameterSeq&,
+    eprosima::fastdds::dds::IContentFilter*& filter_instance)
+{
+    if (std::strcmp(filter_class_name, kInstrumentFilterClass) != 0) {
+        return ReturnCode_t::RETCODE_UNSUPPORTED;
+    }
+
+    // FastDDS passes the existing instance back when only the parameters
+    // change (filter_expression is null then); this filter takes none
+    if (filter_instance && !filter_expression) {
+        return ReturnCode_t::RETCODE_OK;
+    }
+
+    MBOInstrumentFilter* filter = static_cast<MBOInstrumentFilter*>(filter_instance);
+    if (!filter) {
+        filter = std::strcmp(type_name, "MBOBatch") == 0
+            ? new MBOInstrumentFilter(offsetof(MBOBatchHeader, instrument_id), offsetof(MBOBatchHeader, symbol),
+                                      sizeof(MBOBatchHeader))
+            : new MBOInstrumentFilter();
+    }
+    if (!filter->parse(filter_expression)) {
+        if (!filter_instance) {
+            delete filter;
+        }
+        return ReturnCode_t::RETCODE_BAD_PARAMETER;
+    }
+    filter_instance = filter;
+    return ReturnCode_t::RETCODE_OK;
+}
+
+ReturnCode_t MBOInstrumentFilterFactory::delete_content_filter(
+    const char* filter_class_name,
+    eprosima::fastdds::dds::IContentFilter* filter_instance)
+{
+    if (std::strcmp(filter_class_name, kInstrumentFilterClass) != 0) {
+        return ReturnCode_t::RETCODE_UNSUPPORTED;
+    }
+    delete static_cast<MBOInstrumentFilter*>(filter_instance);
+    return ReturnCode_t::RETCODE_OK;
+}
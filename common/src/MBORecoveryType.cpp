@@ -0,0 +1,49 @@
+#include "MBORecoveryType.hpp"
+#include <cstring>
+#include <new>
+
+MBORecoveryType::MBORecoveryType() {
+    setName("MBORecoveryRequest");
+    m_typeSize = sizeof(MBORecoveryRequest);
+    m_isGetKeyDefined = false;
+}
+
+bool MBORecoveryType::serialize(void* data, eprosima::fastrtps::rtps::SerializedPayload_t* payload) {
+    if (payload->max_size < sizeof(MBORecoveryRequest)) {
+        return false;
+    }
+    memcpy(payload->data, data, sizeof(MBORecoveryRequest));
+    payload->length = sizeof(MBORecoveryRequest);
+    return true;
+}
+
+bool MBORecoveryType::deserialize(eprosima::fastrtps::rtps::SerializedPayload_t* payload, void* data) {
+    if (payload->length != sizeof(MBORecoveryRequest)) {
+        return false;
+    }
+    memcpy(data, payload->data, sizeof(MBORecoveryRequest));
+    return true;
+}
+
+std::function<uint32_t()> MBORecoveryType::getSerializedSizeProvider(void*) {
+    return []() -> uint32_t {
+        return sizeof(MBORecoveryRequest);
+    };
+}
+
+void* MBORecoveryType::createData() {
+    return new MBORecoveryRequest();
+}
+
+void MBORecoveryType::deleteData(void* data) {
+    delete static_cast<MBORecoveryRequest*>(data);
+}
+
+bool MBORecoveryType::getKey(void*, eprosima::fastrtps::rtps::InstanceHandle_t*, bool) {
+    return false;
+}
+
+bool MBORecoveryType::construct_sample(void* memory) const {
+    new (memory) MBORecoveryRequest();
+    return true;
+}
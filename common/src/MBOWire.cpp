@@ -0,0 +1,44 @@
+#include "MBOWire.hpp"
+#include <cstring>
+
+MBOWire toWire(const MBOParsed& record) {
+    MBOWire wire;
+    wire.ts_event = record.ts_event;
+    wire.ts_send = 0;
+    wire.order_id = record.order_id;
+    wire.price = record.price;
+    wire.feed_sequence = 0;
+    wire.feed_session = 0;
+    wire.size = record.size;
+    wire.instrument_id = record.instrument_id;
+    wire.sequence = record.sequence;
+    wire.ts_in_delta = record.ts_in_delta;
+    wire.publisher_id = record.publisher_id;
+    wire.rtype = record.rtype;
+    wire.channel_id = record.channel_id;
+    wire.flags = record.flags;
+    wire.action = record.action;
+    wire.side = record.side;
+    std::memcpy(wire.symbol, record.symbol, kSymbolLen);
+    return wire;
+}
+
+MBOParsed fromWire(const MBOWire& wire) {
+    MBOParsed record;
+    record.ts_event = wire.ts_event;
+    record.ts_recv = 0;
+    record.order_id = wire.order_id;
+    record.price = wire.price;
+    record.size = wire.size;
+    record.instrument_id = wire.instrument_id;
+    record.sequence = wire.sequence;
+    record.ts_in_delta = wire.ts_in_delta;
+    record.publisher_id = wire.publisher_id;
+    record.rtype = wire.rtype;
+    record.channel_id = wire.channel_id;
+    record.flags = wire.flags;
+    record.action = wire.action;
+    record.side = wire.side;
+    std::memcpy(record.symbol, wire.symbol, kSymbolLen);
+    return record;
+}
@@ -0,0 +1,63 @@
+#include "MBOWireType.hpp"
+#include <cstring>
+#include <new>
+
+MBOWireType::MBOWireType() {
+    setName("MBOWire");
+    m_typeSize = sizeof(MBOWire);
+    // One instance per instrument
+    m_isGetKeyDefined = true;
+}
+
+bool MBOWireType::serialize(void* data, eprosima::fastrtps::rtps::SerializedPayload_t* payload) {
+    if (payload->max_size < sizeof(MBOWire)) {
+        return false;
+    }
+    memcpy(payload->data, data, sizeof(MBOWire));
+    payload->length = sizeof(MBOWire);
+    return true;
+}
+
+bool MBOWireType::deserialize(eprosima::fastrtps::rtps::SerializedPayload_t* payload, void* data) {
+    if (payload->length != sizeof(MBOWire)) {
+        return false;
+    }
+    memcpy(data, payload->data, sizeof(MBOWire));
+    return true;
+}
+
+std::function<uint32_t()> MBOWireType::getSerializedSizeProvider(void*) {
+    return []() -> uint32_t {
+        return sizeof(MBOWire);
+    };
+}
+
+void* MBOWireType::createData() {
+    return new MBOWire();
+}
+
+void MBOWireType::deleteData(void* data) {
+    delete static_cast<MBOWire*>(data);
+}
+
+void setInstrumentKey(uint32_t instrument_id, eprosima::fastrtps::rtps::InstanceHandle_t* handle) {
+    // The key (instrument_id) is 4 bytes, well under the 16 byte key hash,
+    // so it goes in as-is, big-endian and zero padded, and never needs MD5
+    for (int i = 0; i < 16; ++i) {
+        handle->value[i] = 0;
+    }
+    handle->value[0] = static_cast<uint8_t>(instrument_id >> 24);
+    handle->value[1] = static_cast<uint8_t>(instrument_id >> 16);
+    handle->value[2] = static_cast<uint8_t>(instrument_id >> 8);
+    handle->value[3] = static_cast<uint8_t>(instrument_id);
+}
+
+bool MBOWireType::getKey(void* data, eprosima::fastrtps::rtps::InstanceHandle_t* handle, bool) {
+    setInstrumentKey(static_cast<const MBOWire*>(data)->instrument_id, handle);
+    return true;
+}
+
+bool MBOWireType::construct_sample(void* memory) const {
+    new (memory) MBOWire();
+    return true;
+}
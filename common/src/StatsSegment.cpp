@@ -0,0 +1,129 @@
+#include "StatsSegment.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Timestamp.hpp"
+
+namespace {
+
+// shm_open() name of the segment
+std::string shmName(const std::string& name) {
+    return "/mbo_stats." + name;
+}
+
+} // namespace
+
+StatsSegment::StatsSegment()
+    : base_(nullptr), size_(0), fd_(-1) {
+}
+
+StatsSegment::~StatsSegment() {
+    close();
+}
+
+std::string StatsSegment::path(const std::string& name) {
+    return "/dev/shm" + shmName(name);
+}
+
+bool StatsSegment::create(const std::string& name, StatsService service, size_t shards) {
+    close();
+    // A reader may still map the old segment; unlinking leaves its pages
+    // alone, where truncating one in place would fault the reader
+    shm_unlink(shmName(name).c_str());
+    const int fd = shm_open(shmName(name).c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to create stats segment " << path(name) << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    const size_t size = segmentSize(shards);
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "Failed to size stats segment " << path(name) << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        shm_unlink(shmName(name).c_str());
+        return false;
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        std::cerr << "Failed to map stats segment " << path(name) << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        shm_unlink(shmName(name).c_str());
+        return false;
+    }
+
+    base_ = base;
+    size_ = size;
+    fd_ = fd;
+    name_ = name;
+
+    StatsHeader* header = new (base_) StatsHeader();
+    header->version = kStatsVersion;
+    header->service = service;
+    header->shards = static_cast<uint32_t>(shards);
+    header->pid = static_cast<uint64_t>(getpid());
+    header->started_ns = monotonicNowNs();
+    new (&publisher()) PublisherStats();
+    new (&dispatch()) DispatchStats();
+    for (size_t i = 0; i < shards; ++i) {
+        new (&shard(i)) ShardStats();
+    }
+    header->magic.store(kStatsMagic, std::memory_order_release);
+    return true;
+}
+
+bool StatsSegment::open(const std::string& name) {
+    close();
+    const int fd = shm_open(shmName(name).c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "Failed to open stats segment " << path(name) << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(StatsHeader)) {
+        std::cerr << "Not a stats segment: " << path(name) << std::endl;
+        ::close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid without the descriptor
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "Failed to map stats segment " << path(name) << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    const StatsHeader* header = static_cast<const StatsHeader*>(base);
+    if (header->magic.load(std::memory_order_acquire) != kStatsMagic || header->version != kStatsVersion ||
+        size < segmentSize(header->shards)) {
+        std::cerr << "Not a version " << kStatsVersion << " stats segment (still starting up?): "
+                  << path(name) << std::endl;
+        munmap(base, size);
+        return false;
+    }
+    base_ = base;
+    size_ = size;
+    name_ = name;
+    return true;
+}
+
+void StatsSegment::close() {
+    if (base_) {
+        munmap(base_, size_);
+        base_ = nullptr;
+        size_ = 0;
+    }
+    if (fd_ >= 0) {
+        // Remove the segment unless a later run has already replaced it
+        struct stat ours, current;
+        if (fstat(fd_, &ours) == 0 && stat(path(name_).c_str(), &current) == 0 && ours.st_ino == current.st_ino) {
+            shm_unlink(shmName(name_).c_str());
+        }
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
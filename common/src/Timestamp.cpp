@@ -0,0 +1,126 @@
+#include "Timestamp.hpp"
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant)
+int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void civilFromDays(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+bool readDigits(const char* s, size_t size, size_t& pos, size_t count, unsigned& out) {
+    out = 0;
+    for (size_t i = 0; i < count; ++i, ++pos) {
+        if (pos >= size || s[pos] < '0' || s[pos] > '9') {
+            return false;
+        }
+        out = out * 10 + static_cast<unsigned>(s[pos] - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+uint64_t parseTimestampNs(const char* text, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+
+    // Raw integer nanoseconds
+    if (std::memchr(text, '-', size) == nullptr) {
+        uint64_t ns = 0;
+        for (size_t i = 0; i < size; ++i) {
+            if (text[i] < '0' || text[i] > '9') {
+                return 0;
+            }
+            ns = ns * 10 + static_cast<uint64_t>(text[i] - '0');
+        }
+        return ns;
+    }
+
+    // Reads past the end see '\0', as they would in a std::string
+    auto at = [text, size](size_t pos) { return pos < size ? text[pos] : '\0'; };
+
+    size_t pos = 0;
+    unsigned year, month, day, hour, minute, second;
+    if (!readDigits(text, size, pos, 4, year) || at(pos++) != '-' ||
+        !readDigits(text, size, pos, 2, month) || at(pos++) != '-' ||
+        !readDigits(text, size, pos, 2, day) || (at(pos) != ' ' && at(pos) != 'T')) {
+        return 0;
+    }
+    ++pos;
+    if (!readDigits(text, size, pos, 2, hour) || at(pos++) != ':' ||
+        !readDigits(text, size, pos, 2, minute) || at(pos++) != ':' ||
+        !readDigits(text, size, pos, 2, second)) {
+        return 0;
+    }
+
+    // Optional fraction, padded/truncated to nanoseconds
+    uint64_t nanos = 0;
+    if (pos < size && text[pos] == '.') {
+        ++pos;
+        unsigned digits = 0;
+        while (pos < size && text[pos] >= '0' && text[pos] <= '9') {
+            if (digits < 9) {
+                nanos = nanos * 10 + static_cast<uint64_t>(text[pos] - '0');
+                ++digits;
+            }
+            ++pos;
+        }
+        for (; digits < 9; ++digits) {
+            nanos *= 10;
+        }
+    }
+
+    const int64_t days = daysFromCivil(year, month, day);
+    const int64_t secs = days * 86400 + hour * 3600 + minute * 60 + second;
+    return static_cast<uint64_t>(secs) * 1000000000ULL + nanos;
+}
+
+uint64_t parseTimestampNs(const std::string& text) {
+    return parseTimestampNs(text.data(), text.size());
+}
+
+size_t formatTimestampNs(uint64_t ts_ns, char* out, size_t len) {
+    const uint64_t secs = ts_ns / 1000000000ULL;
+    const uint64_t nanos = ts_ns % 1000000000ULL;
+    int64_t year;
+    unsigned month, day;
+    civilFromDays(static_cast<int64_t>(secs / 86400), year, month, day);
+    const uint64_t sod = secs % 86400;
+
+    const int n = std::snprintf(out, len, "%04lld-%02u-%02u %02u:%02u:%02u.%09llu+00:00",
+                                static_cast<long long>(year), month, day,
+                                static_cast<unsigned>(sod / 3600),
+                                static_cast<unsigned>((sod / 60) % 60),
+                                static_cast<unsigned>(sod % 60),
+                                static_cast<unsigned long long>(nanos));
+    if (n < 0) {
+        return 0;
+    }
+    return static_cast<size_t>(n) < len ? static_cast<size_t>(n) : len - 1;
+}
+
+std::string formatTimestampNs(uint64_t ts_ns) {
+    char buf[48];
+    const size_t n = formatTimestampNs(ts_ns, buf, sizeof(buf));
+    return std::string(buf, n);
+}
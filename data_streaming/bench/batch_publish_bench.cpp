@@ -0,0 +1,174 @@
+// Publishes the DBN file through MBOPublisher with batch sizes 1..64 to a
+// reader in the same process and reports records per second, both as
+// written and as delivered, plus the DDS samples it took.
+//
+//   batch_publish_bench [FILE] [PASSES] [DEADLINE_US]
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fastdds/dds/core/LoanableSequence.hpp>
+#include <fastdds/dds/subscriber/DataReader.hpp>
+#include <fastdds/dds/subscriber/DataReaderListener.hpp>
+#include <fastdds/dds/subscriber/SampleInfo.hpp>
+#include <fastdds/dds/subscriber/Subscriber.hpp>
+
+#include "DbnReader.hpp"
+#include "MBOBatchType.hpp"
+#include "MBOPublisher.hpp"
+#include "MBOWireType.hpp"
+
+namespace {
+
+using namespace eprosima::fastdds::dds;
+using clock_type = std::chrono::steady_clock;
+
+// Counts records as they arrive, unpacking batches
+class CountingReader : public DataReaderListener {
+public:
+    explicit CountingReader(bool batched)
+        : batched_(batched), participant_(nullptr), subscriber_(nullptr), topic_(nullptr), reader_(nullptr),
+          records_(0) {
+        if (batched_) {
+            type_.reset(new MBOBatchType());
+        } else {
+            type_.reset(new MBOWireType());
+        }
+    }
+
+    ~CountingReader() override {
+        if (reader_) subscriber_->delete_datareader(reader_);
+        if (topic_) participant_->delete_topic(topic_);
+        if (subscriber_) participant_->delete_subscriber(subscriber_);
+        if (participant_) DomainParticipantFactory::get_instance()->delete_participant(participant_);
+    }
+
+    bool init() {
+        DomainParticipantQos pqos;
+        pqos.name("batch_publish_bench_reader");
+        participant_ = DomainParticipantFactory::get_instance()->create_participant(0, pqos);
+        if (!participant_) {
+            return false;
+        }
+        type_.register_type(participant_);
+        subscriber_ = participant_->create_subscriber(SUBSCRIBER_QOS_DEFAULT, nullptr);
+        topic_ = participant_->create_topic(batched_ ? kBatchTopicName : "MBOTopic", type_.get_type_name(),
+                                            TOPIC_QOS_DEFAULT);
+        if (!subscriber_ || !topic_) {
+            return false;
+        }
+
+        DataReaderQos rqos = DATAREADER_QOS_DEFAULT;
+        rqos.reliability().kind = RELIABLE_RELIABILITY_QOS;
+        rqos.data_sharing().automatic();
+        rqos.resource_limits().max_instances = 0;
+        reader_ = subscriber_->create_datareader(topic_, rqos, this);
+        return reader_ != nullptr;
+    }
+
+    void on_data_available(DataReader* reader) override {
+        if (batched_) {
+            take<MBOBatch>(reader, [](const MBOBatch& batch) { return batch.header.count; });
+        } else {
+            take<MBOWire>(reader, [](const MBOWire&) { return 1u; });
+        }
+    }
+
+    uint64_t records() const { return records_.load(std::memory_order_relaxed); }
+
+private:
+    template <typename T, typename Count>
+    void take(DataReader* reader, Count count) {
+        LoanableSequence<T> samples;
+        SampleInfoSeq infos;
+        while (reader->take(samples, infos) == ReturnCode_t::RETCODE_OK) {
+            for (LoanableCollection::size_type i = 0; i < infos.length(); ++i) {
+                if (infos[i].valid_data) {
+                    records_.fetch_add(count(samples[i]), std::memory_order_relaxed);
+                }
+            }
+            reader->return_loan(samples, infos);
+        }
+    }
+
+    bool batched_;
+    DomainParticipant* participant_;
+    Subscriber* subscriber_;
+    Topic* topic_;
+    DataReader* reader_;
+    TypeSupport type_;
+    std::atomic<uint64_t> records_;
+};
+
+void run(const std::vector<MBOParsed>& records, size_t batch_size, int passes,
+         std::chrono::microseconds deadline) {
+    CountingReader reader(batch_size > 1);
+    PublisherConfig config;
+    config.batch_size = batch_size;
+    config.batch_deadline = deadline;
+    MBOPublisher publisher(config);
+    if (!reader.init() || !publisher.init()) {
+        std::cerr << "Failed to set up DDS for batch size " << batch_size << std::endl;
+        return;
+    }
+    // Let discovery match the reader before timing
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    const auto start = clock_type::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (const MBOParsed& record : records) {
+            publisher.publish(record);
+        }
+    }
+    publisher.flush();
+    const double write_secs = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    // Wait for delivery to finish (or stall)
+    const uint64_t total = publisher.recordsPublished();
+    uint64_t seen = 0;
+    auto last_progress = clock_type::now();
+    while (reader.records() < total && clock_type::now() - last_progress < std::chrono::seconds(2)) {
+        if (reader.records() != seen) {
+            seen = reader.records();
+            last_progress = clock_type::now();
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    const double deliver_secs = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    std::cout << "batch " << std::setw(2) << batch_size << std::fixed << std::setprecision(2)
+              << "  write " << std::setw(7) << total / write_secs / 1e6 << " M rec/s"
+              << "  delivered " << std::setw(7) << reader.records() / deliver_secs / 1e6 << " M rec/s ("
+              << reader.records() << "/" << total << ")"
+              << "  samples " << publisher.samplesWritten() << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "../data_analyze/CLX5_mbo (2).dbn";
+    const int passes = argc > 2 ? std::stoi(argv[2]) : 5;
+    const std::chrono::microseconds deadline(argc > 3 ? std::stoull(argv[3]) : kDefaultBatchDeadline.count());
+
+    DbnReader dbn_reader;
+    if (!dbn_reader.open(path)) {
+        return 1;
+    }
+    std::vector<MBOParsed> records;
+    MBOParsed record;
+    for (const DbnMboMsg& msg : dbn_reader) {
+        dbn_reader.toParsed(msg, record);
+        records.push_back(record);
+    }
+
+    std::cout << "Publishing " << records.size() << " records x " << passes << " passes, deadline "
+              << deadline.count() << " us" << std::endl;
+    for (size_t batch_size : {1, 4, 16, 64}) {
+        run(records, batch_size, passes, deadline);
+    }
+    return 0;
+}
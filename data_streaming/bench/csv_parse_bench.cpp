@@ -0,0 +1,177 @@
+// CSV parse throughput on orderbook_clean-sized input: the DBN file's
+// records rendered the way data_analyze/main.py exports them, parsed by
+// the old stringstream/stoi path and by CsvScanner with each block
+// classifier. Every parse is checked against the DBN records.
+//
+//   csv_parse_bench [FILE] [PASSES]
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CsvParser.hpp"
+#include "DbnReader.hpp"
+#include "Timestamp.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+std::string buildCsv(const std::vector<MBOParsed>& records) {
+    std::string csv = "ts_event,rtype,publisher_id,instrument_id,action,side,price,size,channel_id,"
+                      "order_id,flags,ts_in_delta,sequence,symbol,datetime\n";
+    char ts[48];
+    char line[256];
+    for (const MBOParsed& r : records) {
+        formatTimestampNs(r.ts_event, ts, sizeof(ts));
+        const int n = std::snprintf(line, sizeof(line), "%s,%u,%u,%u,%c,%c,%.9g,%u,%u,%llu,%u,%d,%u,%s,%s\n",
+                                    ts, r.rtype, r.publisher_id, r.instrument_id, r.action, r.side,
+                                    toDoublePrice(r.price), r.size, r.channel_id,
+                                    static_cast<unsigned long long>(r.order_id), r.flags, r.ts_in_delta,
+                                    r.sequence, symbolString(r).c_str(), ts);
+        csv.append(line, static_cast<size_t>(n));
+    }
+    return csv;
+}
+
+// CSV decoding as data_streaming's main.cpp used to do it
+MBOParsed parseLegacy(const std::string& line) {
+    MBOParsed record{};
+    std::stringstream ss(line);
+    std::string field;
+    std::vector<std::string> fields;
+    while (std::getline(ss, field, ',')) {
+        fields.push_back(field);
+    }
+    if (fields.size() >= 15) {
+        record.ts_event = parseTimestampNs(fields[0]);
+        record.rtype = static_cast<uint8_t>(std::stoi(fields[1]));
+        record.publisher_id = static_cast<uint16_t>(std::stoi(fields[2]));
+        record.instrument_id = static_cast<uint32_t>(std::stoul(fields[3]));
+        record.action = fields[4][0];
+        record.side = fields[5][0];
+        record.price = toFixedPrice(std::stod(fields[6]));
+        record.size = static_cast<uint32_t>(std::stoul(fields[7]));
+        record.channel_id = static_cast<uint8_t>(std::stoi(fields[8]));
+        record.order_id = std::stoull(fields[9]);
+        record.flags = static_cast<uint8_t>(std::stoi(fields[10]));
+        record.ts_in_delta = std::stoi(fields[11]);
+        record.sequence = static_cast<uint32_t>(std::stoul(fields[12]));
+        setSymbol(record, fields[13].data(), fields[13].size());
+    }
+    return record;
+}
+
+bool same(const MBOParsed& a, const MBOParsed& b) {
+    return a.ts_event == b.ts_event && a.order_id == b.order_id && a.price == b.price && a.size == b.size &&
+           a.instrument_id == b.instrument_id && a.sequence == b.sequence && a.ts_in_delta == b.ts_in_delta &&
+           a.publisher_id == b.publisher_id && a.rtype == b.rtype && a.channel_id == b.channel_id &&
+           a.flags == b.flags && a.action == b.action && a.side == b.side &&
+           std::memcmp(a.symbol, b.symbol, kSymbolLen) == 0;
+}
+
+void report(const char* name, size_t bytes, size_t lines, double secs, size_t mismatches) {
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(8) << bytes / secs / 1e9 << " GB/s  "
+              << std::setprecision(1) << std::setw(7) << secs * 1e9 / lines << " ns/line  "
+              << mismatches << " mismatches" << std::endl;
+}
+
+void benchLegacy(const std::string& csv, const std::vector<MBOParsed>& expected, int passes) {
+    size_t mismatches = 0;
+    const auto start = clock_type::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        std::istringstream in(csv);
+        std::string line;
+        std::getline(in, line);
+        size_t i = 0;
+        while (std::getline(in, line)) {
+            const MBOParsed record = parseLegacy(line);
+            if (pass == 0 && !same(record, expected[i])) {
+                ++mismatches;
+            }
+            ++i;
+        }
+    }
+    const double secs = std::chrono::duration<double>(clock_type::now() - start).count();
+    report("stringstream", csv.size() * passes, expected.size() * passes, secs, mismatches);
+}
+
+void benchScanner(const std::string& isa, const std::string& csv, const std::vector<MBOParsed>& expected,
+                  int passes) {
+    if (!CsvScanner::setIsa(isa)) {
+        std::cout << std::left << std::setw(16) << isa << "unsupported on this CPU" << std::endl;
+        return;
+    }
+
+    // Splitting alone
+    size_t fields = 0;
+    auto start = clock_type::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        CsvScanner scanner(csv.data(), csv.data() + csv.size());
+        CsvLine line;
+        while (scanner.next(line)) {
+            fields += line.fields;
+        }
+    }
+    double secs = std::chrono::duration<double>(clock_type::now() - start).count();
+    report((isa + " scan").c_str(), csv.size() * passes, expected.size() * passes, secs, 0);
+
+    // Splitting and decoding
+    size_t mismatches = 0;
+    uint64_t checksum = 0;
+    MBOParsed record;
+    start = clock_type::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        CsvScanner scanner(csv.data(), csv.data() + csv.size());
+        CsvLine line;
+        scanner.next(line);
+        size_t i = 0;
+        while (scanner.next(line)) {
+            parseCSVFields(line, record);
+            checksum += record.order_id ^ static_cast<uint64_t>(record.price);
+            if (pass == 0 && !same(record, expected[i])) {
+                ++mismatches;
+            }
+            ++i;
+        }
+    }
+    secs = std::chrono::duration<double>(clock_type::now() - start).count();
+    report((isa + " parse").c_str(), csv.size() * passes, expected.size() * passes, secs, mismatches);
+    if (fields == 0 || checksum == 0) {
+        std::cout << "(nothing parsed)" << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "../data_analyze/CLX5_mbo (2).dbn";
+    const int passes = argc > 2 ? std::stoi(argv[2]) : 20;
+
+    DbnReader reader;
+    if (!reader.open(path)) {
+        return 1;
+    }
+    std::vector<MBOParsed> records;
+    MBOParsed record;
+    for (const DbnMboMsg& msg : reader) {
+        reader.toParsed(msg, record);
+        record.ts_recv = 0;     // not exported
+        records.push_back(record);
+    }
+
+    const std::string csv = buildCsv(records);
+    std::cout << records.size() << " lines, " << std::fixed << std::setprecision(1) << csv.size() / 1e6
+              << " MB x " << passes << " passes (default classifier: " << CsvScanner::isa() << ")" << std::endl;
+
+    benchLegacy(csv, records, passes < 3 ? passes : 3);
+    for (const char* isa : {"scalar", "sse2", "avx2"}) {
+        benchScanner(isa, csv, records, passes);
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+// Load and scan throughput of DbnReader on a raw Databento MBO file.
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include "DbnReader.hpp"
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "../data_analyze/CLX5_mbo (2).dbn";
+    const int passes = argc > 2 ? std::stoi(argv[2]) : 200;
+
+    using clock = std::chrono::steady_clock;
+    DbnReader reader;
+
+    // Load: map + validate metadata
+    auto t0 = clock::now();
+    for (int i = 0; i < passes; ++i) {
+        if (!reader.open(path)) {
+            return 1;
+        }
+    }
+    auto t1 = clock::now();
+
+    // Scan: walk every MBO record and decode it into MBOParsed
+    size_t records = 0;
+    uint64_t checksum = 0;
+    MBOParsed record;
+    auto t2 = clock::now();
+    for (int i = 0; i < passes; ++i) {
+        for (const DbnMboMsg& msg : reader) {
+            reader.toParsed(msg, record);
+            checksum += record.order_id ^ static_cast<uint64_t>(record.price);
+            ++records;
+        }
+    }
+    auto t3 = clock::now();
+
+    const size_t per_pass = records / passes;
+    auto secs = [](clock::duration d) { return std::chrono::duration<double>(d).count(); };
+    const double load_s = secs(t1 - t0) / passes;
+    const double scan_s = secs(t3 - t2) / passes;
+
+    const DbnMetadata& meta = reader.metadata();
+    std::cout << "file:        " << path << "\n"
+              << "dataset:     " << meta.dataset << " (DBN v" << int(meta.version) << ")\n"
+              << "records:     " << per_pass << "\n"
+              << std::fixed << std::setprecision(2)
+              << "load:        " << load_s * 1e6 << " us/file  ("
+              << per_pass / load_s / 1e6 << " M records/s)\n"
+              << "scan:        " << scan_s * 1e6 << " us/pass  ("
+              << per_pass / scan_s / 1e6 << " M records/s)\n"
+              << "load+scan:   " << per_pass / (load_s + scan_s) / 1e6 << " M records/s\n"
+              << "(checksum " << checksum << ")" << std::endl;
+    return 0;
+}
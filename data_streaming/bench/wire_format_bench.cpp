@@ -0,0 +1,140 @@
+// Compares the legacy CSV message path against the binary MBOWire record:
+// bytes on the wire and encode+decode cost per message.
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "MBOParsed.hpp"
+#include "MBOWire.hpp"
+#include "Timestamp.hpp"
+
+namespace {
+
+// CSV encoding as MBOPublisher::publish used to do it (with the
+// datetime column derived from ts_event)
+std::string encodeCSV(const MBOParsed& record) {
+    std::ostringstream oss;
+    const std::string ts = formatTimestampNs(record.ts_event);
+    oss << ts << ","
+        << int(record.rtype) << ","
+        << record.publisher_id << ","
+        << record.instrument_id << ","
+        << record.action << ","
+        << record.side << ","
+        << toDoublePrice(record.price) << ","
+        << record.size << ","
+        << int(record.channel_id) << ","
+        << record.order_id << ","
+        << int(record.flags) << ","
+        << record.ts_in_delta << ","
+        << record.sequence << ","
+        << symbolString(record) << ","
+        << ts;
+    return oss.str();
+}
+
+// CSV decoding as MBOSubscriber::parseCSVString used to do it
+MBOParsed decodeCSV(const std::string& csv_line) {
+    MBOParsed record{};
+    std::stringstream ss(csv_line);
+    std::string field;
+    std::vector<std::string> fields;
+
+    while (std::getline(ss, field, ',')) {
+        fields.push_back(field);
+    }
+
+    if (fields.size() >= 15) {
+        record.ts_event = parseTimestampNs(fields[0]);
+        record.rtype = static_cast<uint8_t>(std::stoi(fields[1]));
+        record.publisher_id = static_cast<uint16_t>(std::stoi(fields[2]));
+        record.instrument_id = static_cast<uint32_t>(std::stoul(fields[3]));
+        record.action = fields[4][0];
+        record.side = fields[5][0];
+        record.price = toFixedPrice(std::stod(fields[6]));
+        record.size = static_cast<uint32_t>(std::stoul(fields[7]));
+        record.channel_id = static_cast<uint8_t>(std::stoi(fields[8]));
+        record.order_id = std::stoull(fields[9]);
+        record.flags = static_cast<uint8_t>(std::stoi(fields[10]));
+        record.ts_in_delta = std::stoi(fields[11]);
+        record.sequence = static_cast<uint32_t>(std::stoul(fields[12]));
+        setSymbol(record, fields[13].data(), fields[13].size());
+    }
+    return record;
+}
+
+std::vector<MBOParsed> makeRecords(size_t count) {
+    static const char actions[] = {'A', 'C', 'M', 'T'};
+    std::vector<MBOParsed> records;
+    records.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        MBOParsed r{};
+        r.ts_event = 1760967000000000000ULL + i * 1000;
+        r.rtype = 160;
+        r.publisher_id = 1;
+        r.instrument_id = 432669;
+        r.action = actions[i % 4];
+        r.side = (i & 1) ? 'B' : 'A';
+        r.price = 61000000000LL + static_cast<int64_t>(i % 50) * 10000000LL;
+        r.size = 1 + static_cast<uint32_t>(i % 20);
+        r.channel_id = 0;
+        r.order_id = 6871251000000000000ULL + i;
+        r.flags = 128;
+        r.ts_in_delta = 17000 + static_cast<int32_t>(i % 1000);
+        r.sequence = 5000000 + static_cast<uint32_t>(i);
+        setSymbol(r, "CLX5", 4);
+        records.push_back(r);
+    }
+    return records;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t count = argc > 1 ? std::stoul(argv[1]) : 200000;
+    std::vector<MBOParsed> records = makeRecords(count);
+
+    using clock = std::chrono::steady_clock;
+    uint64_t checksum = 0;
+
+    // Legacy CSV path
+    size_t csv_bytes = 0;
+    auto t0 = clock::now();
+    for (const auto& r : records) {
+        std::string msg = encodeCSV(r);
+        csv_bytes += msg.size();
+        MBOParsed back = decodeCSV(msg);
+        checksum += back.order_id;
+    }
+    auto t1 = clock::now();
+
+    // Binary wire path: encode into a payload buffer, decode back out
+    alignas(64) unsigned char payload[sizeof(MBOWire)];
+    auto t2 = clock::now();
+    for (const auto& r : records) {
+        MBOWire wire = toWire(r);
+        std::memcpy(payload, &wire, sizeof(wire));
+        MBOWire received;
+        std::memcpy(&received, payload, sizeof(received));
+        MBOParsed back = fromWire(received);
+        checksum += back.order_id;
+    }
+    auto t3 = clock::now();
+
+    auto nsPerMsg = [count](clock::duration d) {
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()) / count;
+    };
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "messages:        " << count << "\n"
+              << "csv   bytes/msg: " << static_cast<double>(csv_bytes) / count
+              << "  ns/msg: " << nsPerMsg(t1 - t0) << "\n"
+              << "wire  bytes/msg: " << static_cast<double>(sizeof(MBOWire))
+              << "  ns/msg: " << nsPerMsg(t3 - t2) << "\n"
+              << "(checksum " << checksum << ")" << std::endl;
+    return 0;
+}
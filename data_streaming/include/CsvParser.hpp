@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "MBOParsed.hpp"
+
+// Columns of the exported CSV (data_analyze/main.py) that carry a record
+constexpr size_t kCsvMinFields = 15;
+
+// Separators CsvScanner keeps per line; later fields are ignored
+constexpr size_t kCsvMaxFields = 16;
+
+// One line found by CsvScanner. Field i runs from just after ends[i - 1]
+// (from begin for field 0) up to ends[i], which is its comma or the end
+// of the line. No quoting: the export never quotes these columns.
+struct CsvLine {
+    const char* begin;
+    const char* end;            // excludes the '\n' and any '\r' before it
+    size_t fields;              // capped at kCsvMaxFields
+    const char* ends[kCsvMaxFields];
+
+    const char* fieldBegin(size_t i) const { return i == 0 ? begin : ends[i - 1] + 1; }
+    const char* fieldEnd(size_t i) const { return ends[i]; }
+};
+
+// Splits a buffer into lines and fields without copying or allocating.
+// Each 64 byte block is classified with one vector compare per separator
+// (AVX2 when the CPU has it, SSE2 otherwise, scalar off x86) into a
+// bitmask of commas and newlines, which is then walked bit by bit.
+class CsvScanner {
+public:
+    CsvScanner(const char* begin, const char* end);
+
+    // Next line; false at the end of the buffer. A last line without a
+    // newline is still returned.
+    bool next(CsvLine& line);
+
+    // Start of the line next() returns next
+    const char* position() const { return pos_; }
+
+    // Instruction set the block classifier uses ("avx2", "sse2", "scalar")
+    static const char* isa();
+
+    // Force a classifier for scanners created afterwards (benchmarks).
+    // False if the name is unknown or the CPU lacks it.
+    static bool setIsa(const std::string& name);
+
+private:
+    using MaskFn = uint64_t (*)(const char* block);
+
+    // Separator bits of the block at base_, clipped to the buffer
+    uint64_t load();
+
+    const char* end_;
+    const char* pos_;
+    const char* base_;
+    uint64_t bits_;             // separators of the block at base_ not consumed yet
+    MaskFn mask_;
+};
+
+// Decode a line's fields into record with hand-rolled integer and
+// fixed-point parsers. False if the line has fewer than kCsvMinFields
+// fields.
+bool parseCSVFields(const CsvLine& line, MBOParsed& record);
+
+// Parse one CSV line (without its line terminator) into record, straight
+// from the buffer and without allocating. False if the line has fewer
+// than kCsvMinFields fields.
+bool parseCSVLine(const char* begin, const char* end, MBOParsed& record);
@@ -3,25 +3,166 @@
 #include <fastdds/dds/domain/DomainParticipant.hpp>
 #include <fastdds/dds/publisher/Publisher.hpp>
 #include <fastdds/dds/publisher/DataWriter.hpp>
+#include <fastdds/dds/subscriber/Subscriber.hpp>
+#include <fastdds/dds/subscriber/DataReader.hpp>
+#include <fastdds/dds/subscriber/DataReaderListener.hpp>
 #include <fastdds/dds/topic/Topic.hpp>
 #include <fastdds/dds/topic/TypeSupport.hpp>
 #include <fastdds/dds/core/status/PublicationMatchedStatus.hpp>
+#include "FaultInjector.hpp"
+#include "MBOBatch.hpp"
+#include "MBOInstrumentFilter.hpp"
 #include "MBOParsed.hpp"
+#include "MBORecovery.hpp"
+#include "RetransmitBuffer.hpp"
+#include "StatsSegment.hpp"
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ostream>
 #include <string>
+#include <unordered_map>
 
+// Default wait before a partly filled batch goes out anyway
+constexpr std::chrono::microseconds kDefaultBatchDeadline{100};
 
-class MBOPublisher {
+// Quiet spells at least this long are preceded by a heartbeat
+constexpr std::chrono::milliseconds kHeartbeatGap{500};
+
+struct PublisherConfig {
+    // Records per sample. 1 writes each record to MBOTopic on its own;
+    // more packs runs of one instrument into MBOBatch samples on
+    // MBOBatchTopic (at most kMaxBatchRecords).
+    size_t batch_size = 1;
+
+    // Longest a record waits in a partly filled batch
+    std::chrono::microseconds batch_deadline = kDefaultBatchDeadline;
+
+    // Records of each instrument kept to answer recovery requests
+    size_t retransmit_depth = kDefaultRetransmitDepth;
+
+    // Drop and reorder outgoing records (testing recovery); resends are
+    // never faulted
+    FaultConfig faults;
+};
+
+// Every record goes out stamped with its instrument's feed sequence
+// (contiguous from 1) and the publisher's feed session, so subscribers
+// can spot gaps, reordering and restarts, and with the host's monotonic
+// clock, so subscribers on the same host can time tick-to-book. Recent records are kept per
+// instrument, and a subscriber that lost some asks for them again on
+// MBORecoveryTopic; they are resent on the data topic.
+class MBOPublisher : public eprosima::fastdds::dds::DataReaderListener {
 public:
-    MBOPublisher(const std::string& topic_name = "MBOTopic");
+    explicit MBOPublisher(const PublisherConfig& config = PublisherConfig());
     ~MBOPublisher();
 
+    // Keep counters in stats (a stats segment's block) instead of the
+    // publisher's own; before init()
+    void setStats(PublisherStats* stats) { this->stats = stats; }
+
     bool init();
+
+    // Start a new feed session: every instrument's sequence restarts at 1
+    // and subscribers reset their books. Call before each replay pass.
+    void beginSession();
+
     void publish(const MBOParsed& record);
 
+    // Write the pending batch now, if there is one
+    void flush();
+
+    // The caller is about to go quiet for gap: write the pending batch now
+    // if its deadline would pass in the meantime, and send a heartbeat if
+    // the gap is long
+    void idle(std::chrono::nanoseconds gap);
+
+    // Resend every instrument's newest record. Subscribers that have it
+    // drop the duplicate; one that lost the end of a burst learns of the
+    // gap here instead of at the instrument's next record.
+    void heartbeat();
+
+    uint64_t recordsPublished() const { return stats->records_out.get(); }
+    uint64_t samplesWritten() const { return stats->samples_out.get(); }
+    uint64_t recordsResent() const { return stats->records_resent.get(); }
+    uint32_t session() const { return feed_session; }
+
+    // Print recovery and fault injection counters
+    void printStats(std::ostream& out) const;
+
+    // Recovery requests (DataReaderListener)
+    void on_data_available(eprosima::fastdds::dds::DataReader* reader) override;
+
 private:
+    using clock_type = std::chrono::steady_clock;
+
+    // Sequence and history of one instrument's feed
+    struct InstrumentFeed {
+        explicit InstrumentFeed(size_t depth) : next_sequence(1), history(depth) {}
+
+        uint32_t next_sequence;
+        RetransmitBuffer history;
+    };
+
+    InstrumentFeed& feedFor(uint32_t instrument_id);
+
+    // Write one stamped record, batched or not
+    void send(const MBOWire& wire);
+
+    // Resend what is still held of request's range
+    void resend(const MBORecoveryRequest& request);
+
+    // Instance handle for instrument_id, registered (from sample) on first use
+    const eprosima::fastdds::dds::InstanceHandle_t& instanceFor(uint32_t instrument_id, void* sample);
+
+    // Start a batch for wire's instrument, in a loaned sample if possible
+    void startBatch(const MBOWire& wire);
+
+    // Write the pending batch, if any (feed_mutex held)
+    void writeBatch();
+
+    // heartbeat() with feed_mutex held
+    void sendHeartbeat();
+
+    PublisherConfig config;
+
     eprosima::fastdds::dds::DomainParticipant* participant;
     eprosima::fastdds::dds::Publisher* publisher;
     eprosima::fastdds::dds::Topic* topic;
     eprosima::fastdds::dds::DataWriter* writer;
     eprosima::fastdds::dds::TypeSupport type;
-};
\ No newline at end of file
+
+    // Recovery requests from subscribers
+    eprosima::fastdds::dds::Subscriber* recovery_subscriber;
+    eprosima::fastdds::dds::Topic* recovery_topic;
+    eprosima::fastdds::dds::DataReader* recovery_reader;
+    eprosima::fastdds::dds::TypeSupport recovery_type;
+
+    // Lets the writer evaluate subscribers' instrument filters itself and
+    // skip sending them samples they would discard
+    MBOInstrumentFilterFactory filter_factory;
+
+    // instrument_id -> registered instance
+    std::unordered_map<uint32_t, eprosima::fastdds::dds::InstanceHandle_t> instances;
+
+    // Batch being filled: a loaned sample, or batch_storage when loans
+    // aren't available. Null between batches.
+    MBOBatch* batch;
+    bool batch_loaned;
+    clock_type::time_point batch_started;
+    std::unique_ptr<MBOBatch> batch_storage;
+
+    // Feed state, shared with the recovery listener's thread. Uncontended
+    // unless a resend is running, which is rare.
+    mutable std::mutex feed_mutex;
+    uint32_t feed_session;
+    std::unordered_map<uint32_t, InstrumentFeed> feeds;
+    uint32_t last_instrument;
+    InstrumentFeed* last_feed;
+    std::unique_ptr<FaultInjector<MBOWire>> faults;
+
+    // Counters, written by the publishing thread or with feed_mutex held
+    PublisherStats local_stats;
+    PublisherStats* stats;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "DbnReader.hpp"
+#include "MBOParsed.hpp"
+#include "SPSCRing.hpp"
+#include "StatsSegment.hpp"
+
+// Records parsed ahead of the publisher (64 bytes each)
+constexpr size_t kDefaultPrefetchRecords = 16384;
+
+// Streams records out of a memory-mapped .dbn or CSV file. A loader thread
+// parses ahead into a bounded ring, so publishing starts as soon as the
+// first records are decoded and memory stays flat whatever the file size:
+// the ring is fixed, and pages the loader has finished with are dropped
+// from the mapping (they come back from the page cache on the next pass).
+class RecordLoader {
+public:
+    explicit RecordLoader(size_t prefetch = kDefaultPrefetchRecords);
+    ~RecordLoader();
+
+    RecordLoader(const RecordLoader&) = delete;
+    RecordLoader& operator=(const RecordLoader&) = delete;
+
+    // Count loaded records and malformed lines in stats (a stats
+    // segment's block) instead of the loader's own; before open()
+    void setStats(PublisherStats* stats) { stats_ = stats; }
+
+    // Map the file (.dbn by suffix, CSV otherwise) and start loading the
+    // first pass. False (with the reason reported) on failure.
+    bool open(const std::string& path);
+
+    // Consumer: next record of the pass, waiting for the loader if it is
+    // behind. False once the pass is exhausted.
+    bool next(MBOParsed& record);
+
+    // Consumer: start another pass from the top of the file
+    void rewind();
+
+    bool isDbn() const { return is_dbn_; }
+    const DbnReader& dbn() const { return dbn_; }
+
+    // CSV lines skipped for having too few fields, over all passes
+    uint64_t malformed() const { return stats_->parse_errors.get(); }
+
+private:
+    void run();
+
+    // Loader thread: parse one pass into the ring
+    void loadDbn();
+    void loadCsv();
+
+    // Loader thread: queue a record, waiting while the ring is full.
+    // False if the loader is shutting down.
+    bool push(const MBOParsed& record);
+
+    // Drop the pages of the mapping from from's page up to to's page (the
+    // one to is in stays); returns where the next release should start
+    static const char* release(const char* from, const char* to);
+
+    bool is_dbn_;
+    DbnReader dbn_;
+
+    // CSV mapping
+    int fd_;
+    void* map_;
+    size_t map_size_;
+
+    SPSCRing<MBOParsed> ring_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    // Pass handshake: the consumer asks for pass N, the loader reports
+    // when it has queued all of pass N
+    uint64_t pass_;
+    std::atomic<uint64_t> pass_requested_;
+    std::atomic<uint64_t> pass_loaded_;
+
+    // Written by the loader thread (records_in and parse_errors only)
+    PublisherStats local_stats_;
+    PublisherStats* stats_;
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include "LatencyHistogram.hpp"
+
+// How fast records are replayed
+enum class ReplayMode {
+    RealTime,       // ts_event gaps as recorded
+    Speed,          // ts_event gaps divided by a multiplier
+    FixedRate,      // evenly spaced at N records per second
+    Max             // as fast as the publisher takes them
+};
+
+struct ReplayConfig {
+    ReplayMode mode = ReplayMode::RealTime;
+    double speed = 1.0;
+    double rate = 0.0;
+
+    // Parse "realtime", "speed:X", "rate:N" or "max". Returns false on
+    // malformed input.
+    static bool parse(const std::string& spec, ReplayConfig& out);
+};
+
+// Paces a replay against the monotonic clock. Each record's due time is
+// derived from the start of the pass (from its ts_event offset, or its
+// index at a fixed rate), not from the previous record, so waiting errors
+// don't accumulate. Waits sleep while the deadline is far off and spin
+// for the last stretch, which OS sleep granularity can't hit.
+class ReplayScheduler {
+public:
+    explicit ReplayScheduler(const ReplayConfig& config);
+
+    // Start a pass: the next record is due immediately
+    void beginPass();
+
+    // Time left until the record with ts_event is due (zero if it is late)
+    std::chrono::nanoseconds untilDue(uint64_t ts_event);
+
+    // Block until the record with ts_event is due, and record how late we
+    // actually woke
+    void waitFor(uint64_t ts_event);
+
+    // Print achieved vs target rate and lateness percentiles for the pass
+    void endPass(std::ostream& out);
+
+private:
+    using clock_type = std::chrono::steady_clock;
+
+    // Due time of the next record
+    clock_type::time_point dueTime(uint64_t ts_event);
+
+    ReplayConfig config_;
+    clock_type::duration interval_;     // FixedRate spacing
+
+    unsigned pass_;
+    uint64_t records_;
+    clock_type::time_point start_;
+    uint64_t first_ts_;
+    uint64_t last_ts_;                  // ts_event never steps backwards in pacing
+
+    LatencyHistogram lateness_;
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MBOWire.hpp"
+
+// Records of each instrument the publisher keeps for resending
+constexpr size_t kDefaultRetransmitDepth = 65536;
+
+// The most recent records of one instrument's feed, by feed_sequence.
+// Storage grows with use up to the depth (rounded up to a power of two),
+// then the oldest record is overwritten.
+class RetransmitBuffer {
+public:
+    explicit RetransmitBuffer(size_t depth = kDefaultRetransmitDepth);
+
+    // Keep wire; its feed_sequence follows the last one stored (or is the
+    // first after clear())
+    void store(const MBOWire& wire);
+
+    // The stored record with this sequence, or null if it has been
+    // overwritten or was never stored
+    const MBOWire* find(uint32_t sequence) const;
+
+    // Oldest and newest sequences held (first() > last() when empty)
+    uint32_t first() const { return first_; }
+    uint32_t last() const { return last_; }
+
+    void clear();
+
+private:
+    std::vector<MBOWire> slots_;
+    size_t mask_;
+    uint32_t first_;
+    uint32_t last_;
+};
@@ -0,0 +1,299 @@
+#include "CsvParser.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include "Timestamp.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CSV_SCANNER_X86 1
+#endif
+
+namespace {
+
+uint64_t maskScalar(const char* block) {
+    uint64_t mask = 0;
+    for (unsigned i = 0; i < 64; ++i) {
+        mask |= static_cast<uint64_t>(block[i] == ',' || block[i] == '\n') << i;
+    }
+    return mask;
+}
+
+#ifdef CSV_SCANNER_X86
+// SSE2 is part of x86-64, so this needs no CPU check. (SSE4.2's
+// PCMPISTRM can match both separators in one instruction, but two
+// PCMPEQB are cheaper for a two character set.)
+uint64_t maskSse2(const char* block) {
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    uint64_t mask = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        const __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, newline));
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(hits)) & 0xFFFF) << (16 * i);
+    }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+uint64_t maskAvx2(const char* block) {
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    const __m256i lo_hits = _mm256_or_si256(_mm256_cmpeq_epi8(lo, comma), _mm256_cmpeq_epi8(lo, newline));
+    const __m256i hi_hits = _mm256_or_si256(_mm256_cmpeq_epi8(hi, comma), _mm256_cmpeq_epi8(hi, newline));
+    return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(lo_hits))) |
+           static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(hi_hits))) << 32;
+}
+#endif
+
+// Picked on first use; setIsa() can override it
+struct MaskSelection {
+    uint64_t (*fn)(const char*);
+    const char* name;
+};
+
+MaskSelection selectMask() {
+#ifdef CSV_SCANNER_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return {maskAvx2, "avx2"};
+    }
+    return {maskSse2, "sse2"};
+#else
+    return {maskScalar, "scalar"};
+#endif
+}
+
+MaskSelection& maskSelection() {
+    static MaskSelection selection = selectMask();
+    return selection;
+}
+
+constexpr int64_t kPow10[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+template <typename T>
+T parseUnsigned(const char* pos, const char* end) {
+    T value = 0;
+    for (; pos < end; ++pos) {
+        const unsigned digit = static_cast<unsigned>(*pos) - '0';
+        if (digit > 9) {
+            break;
+        }
+        value = static_cast<T>(value * 10 + digit);
+    }
+    return value;
+}
+
+template <typename T>
+T parseSigned(const char* pos, const char* end) {
+    const bool negative = pos < end && *pos == '-';
+    const T magnitude = static_cast<T>(parseUnsigned<uint64_t>(negative ? pos + 1 : pos, end));
+    return negative ? static_cast<T>(-magnitude) : magnitude;
+}
+
+// Anything the decimal parser doesn't handle (exponents, NaN)
+int64_t parsePriceSlow(const char* pos, const char* end) {
+    char buf[64];
+    const size_t len = static_cast<size_t>(end - pos) < sizeof(buf) - 1 ? static_cast<size_t>(end - pos) : sizeof(buf) - 1;
+    std::memcpy(buf, pos, len);
+    buf[len] = '\0';
+    const double price = std::strtod(buf, nullptr);
+    if (!std::isfinite(price)) {
+        // DBN's undefined price
+        return std::numeric_limits<int64_t>::max();
+    }
+    return toFixedPrice(price);
+}
+
+// Decimal text straight to kPriceScale fixed point, rounding past the
+// ninth fractional digit
+int64_t parsePrice(const char* pos, const char* end) {
+    const char* start = pos;
+    const bool negative = pos < end && *pos == '-';
+    if (negative || (pos < end && *pos == '+')) {
+        ++pos;
+    }
+
+    int64_t whole = 0;
+    for (; pos < end && static_cast<unsigned>(*pos) - '0' <= 9; ++pos) {
+        whole = whole * 10 + (*pos - '0');
+    }
+
+    int64_t fraction = 0;
+    unsigned digits = 0;
+    bool round_up = false;
+    if (pos < end && *pos == '.') {
+        for (++pos; pos < end && static_cast<unsigned>(*pos) - '0' <= 9; ++pos) {
+            if (digits < 9) {
+                fraction = fraction * 10 + (*pos - '0');
+            } else if (digits == 9) {
+                round_up = *pos >= '5';
+            }
+            ++digits;
+        }
+    }
+    if (pos != end) {
+        return parsePriceSlow(start, end);
+    }
+
+    const int64_t value = whole * kPriceScale + fraction * kPow10[digits < 9 ? 9 - digits : 0] + round_up;
+    return negative ? -value : value;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant)
+int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+// Digits at fixed positions; false if any of them isn't one
+inline bool fixedDigits(const char* pos, unsigned count, unsigned& out) {
+    out = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        const unsigned digit = static_cast<unsigned>(pos[i]) - '0';
+        if (digit > 9) {
+            return false;
+        }
+        out = out * 10 + digit;
+    }
+    return true;
+}
+
+// The export always writes "YYYY-MM-DD HH:MM:SS.nnnnnnnnn" (plus a zone
+// suffix), so read it at fixed offsets; anything else goes through the
+// general parser
+uint64_t parseTimestamp(const char* pos, const char* end) {
+    unsigned year, month, day, hour, minute, second, high, low;
+    if (end - pos < 29 || pos[4] != '-' || pos[7] != '-' || (pos[10] != ' ' && pos[10] != 'T') ||
+        pos[13] != ':' || pos[16] != ':' || pos[19] != '.' ||
+        (end - pos > 29 && static_cast<unsigned>(pos[29]) - '0' <= 9) ||
+        !fixedDigits(pos, 4, year) || !fixedDigits(pos + 5, 2, month) || !fixedDigits(pos + 8, 2, day) ||
+        !fixedDigits(pos + 11, 2, hour) || !fixedDigits(pos + 14, 2, minute) ||
+        !fixedDigits(pos + 17, 2, second) || !fixedDigits(pos + 20, 4, high) || !fixedDigits(pos + 24, 5, low)) {
+        return parseTimestampNs(pos, static_cast<size_t>(end - pos));
+    }
+    const int64_t secs = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    return static_cast<uint64_t>(secs) * 1000000000ULL + uint64_t(high) * 100000 + low;
+}
+
+} // namespace
+
+CsvScanner::CsvScanner(const char* begin, const char* end)
+    : end_(end), pos_(begin), base_(begin), bits_(0), mask_(maskSelection().fn) {
+    if (begin < end) {
+        bits_ = load();
+    }
+}
+
+const char* CsvScanner::isa() {
+    return maskSelection().name;
+}
+
+bool CsvScanner::setIsa(const std::string& name) {
+    if (name == "scalar") {
+        maskSelection() = {maskScalar, "scalar"};
+        return true;
+    }
+#ifdef CSV_SCANNER_X86
+    if (name == "sse2") {
+        maskSelection() = {maskSse2, "sse2"};
+        return true;
+    }
+    if (name == "avx2" && __builtin_cpu_supports("avx2")) {
+        maskSelection() = {maskAvx2, "avx2"};
+        return true;
+    }
+#endif
+    return false;
+}
+
+uint64_t CsvScanner::load() {
+    if (end_ - base_ >= 64) {
+        return mask_(base_);
+    }
+    // Never read past the buffer: classify a zero-padded copy of the tail
+    alignas(64) char tail[64] = {};
+    std::memcpy(tail, base_, static_cast<size_t>(end_ - base_));
+    return mask_(tail);
+}
+
+bool CsvScanner::next(CsvLine& line) {
+    if (pos_ >= end_) {
+        return false;
+    }
+    line.begin = pos_;
+    line.fields = 0;
+
+    const char* eol = end_;
+    for (;;) {
+        while (bits_ == 0) {
+            base_ += 64;
+            if (base_ >= end_) {
+                break;
+            }
+            bits_ = load();
+        }
+        if (bits_ == 0) {
+            // Last line without a newline
+            pos_ = end_;
+            break;
+        }
+
+        const char* sep = base_ + __builtin_ctzll(bits_);
+        bits_ &= bits_ - 1;
+        if (*sep == '\n') {
+            eol = sep;
+            pos_ = sep + 1;
+            break;
+        }
+        if (line.fields < kCsvMaxFields) {
+            line.ends[line.fields++] = sep;
+        }
+    }
+
+    if (eol > line.begin && eol[-1] == '\r') {
+        --eol;
+    }
+    line.end = eol;
+    if (line.fields < kCsvMaxFields) {
+        line.ends[line.fields++] = eol;
+    }
+    return true;
+}
+
+bool parseCSVFields(const CsvLine& line, MBOParsed& record) {
+    if (line.fields < kCsvMinFields) {
+        return false;
+    }
+
+    record.ts_event = parseTimestamp(line.begin, line.fieldEnd(0));
+    record.ts_recv = 0;
+    record.rtype = parseUnsigned<uint8_t>(line.fieldBegin(1), line.fieldEnd(1));
+    record.publisher_id = parseUnsigned<uint16_t>(line.fieldBegin(2), line.fieldEnd(2));
+    record.instrument_id = parseUnsigned<uint32_t>(line.fieldBegin(3), line.fieldEnd(3));
+    record.action = line.fieldBegin(4) < line.fieldEnd(4) ? *line.fieldBegin(4) : '\0';
+    record.side = line.fieldBegin(5) < line.fieldEnd(5) ? *line.fieldBegin(5) : '\0';
+    record.price = parsePrice(line.fieldBegin(6), line.fieldEnd(6));
+    record.size = parseUnsigned<uint32_t>(line.fieldBegin(7), line.fieldEnd(7));
+    record.channel_id = parseUnsigned<uint8_t>(line.fieldBegin(8), line.fieldEnd(8));
+    record.order_id = parseUnsigned<uint64_t>(line.fieldBegin(9), line.fieldEnd(9));
+    record.flags = parseUnsigned<uint8_t>(line.fieldBegin(10), line.fieldEnd(10));
+    record.ts_in_delta = parseSigned<int32_t>(line.fieldBegin(11), line.fieldEnd(11));
+    record.sequence = parseUnsigned<uint32_t>(line.fieldBegin(12), line.fieldEnd(12));
+    setSymbol(record, line.fieldBegin(13), static_cast<size_t>(line.fieldEnd(13) - line.fieldBegin(13)));
+    return true;
+}
+
+bool parseCSVLine(const char* begin, const char* end, MBOParsed& record) {
+    CsvScanner scanner(begin, end);
+    CsvLine line;
+    return scanner.next(line) && parseCSVFields(line, record);
+}
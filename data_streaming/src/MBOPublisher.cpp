@@ -1,60 +1,55 @@
 #include "MBOPublisher.hpp"
-#include <fastdds/dds/topic/TopicDataType.hpp>
+#include "MBOBatchType.hpp"
+#include "MBORecoveryType.hpp"
+#include "MBOWireType.hpp"
+#include "Timestamp.hpp"
+#include <fastdds/dds/core/LoanableSequence.hpp>
+#include <fastdds/dds/subscriber/SampleInfo.hpp>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
-#include <sstream>
+#include <random>
 
-// Simple string type for FastDDS
-class StringType : public eprosima::fastdds::dds::TopicDataType {
-public:
-    StringType() {
-        setName("StringType");
-        m_typeSize = 4096;  // max string size
-        m_isGetKeyDefined = false;
-    }
-
-    bool serialize(void* data, eprosima::fastrtps::rtps::SerializedPayload_t* payload) override {
-        std::string* str = static_cast<std::string*>(data);
-        payload->length = static_cast<uint32_t>(str->size());
-        memcpy(payload->data, str->data(), str->size());
-        return true;
-    }
-
-    bool deserialize(eprosima::fastrtps::rtps::SerializedPayload_t* payload, void* data) override {
-        std::string* str = static_cast<std::string*>(data);
-        str->assign(reinterpret_cast<char*>(payload->data), payload->length);
-        return true;
-    }
-
-    std::function<uint32_t()> getSerializedSizeProvider(void* data) override {
-        return [data]() -> uint32_t {
-            return static_cast<uint32_t>(static_cast<std::string*>(data)->size());
-        };
-    }
-
-    void* createData() override {
-        return new std::string();
+MBOPublisher::MBOPublisher(const PublisherConfig& config)
+    : config(config), participant(nullptr), publisher(nullptr), topic(nullptr), writer(nullptr),
+      recovery_subscriber(nullptr), recovery_topic(nullptr), recovery_reader(nullptr),
+      batch(nullptr), batch_loaned(false), feed_session(0), last_instrument(0), last_feed(nullptr),
+      stats(&local_stats)
+{
+    this->config.batch_size = std::min(std::max<size_t>(this->config.batch_size, 1), kMaxBatchRecords);
+    if (this->config.batch_size > 1) {
+        type.reset(new MBOBatchType());
+        batch_storage = std::make_unique<MBOBatch>();
+    } else {
+        type.reset(new MBOWireType());
     }
-
-    void deleteData(void* data) override {
-        delete static_cast<std::string*>(data);
+    recovery_type.reset(new MBORecoveryType());
+    if (this->config.faults.enabled()) {
+        faults = std::make_unique<FaultInjector<MBOWire>>(this->config.faults);
     }
 
-    bool getKey(void*, eprosima::fastrtps::rtps::InstanceHandle_t*, bool) override {
-        return false;
+    // A random first session, so a restarted publisher never reuses the
+    // last one's numbering
+    std::random_device random;
+    feed_session = static_cast<uint32_t>(random());
+    if (feed_session == 0) {
+        feed_session = 1;
     }
-};
-
-MBOPublisher::MBOPublisher(const std::string& topic_name)
-    : participant(nullptr), publisher(nullptr), topic(nullptr), writer(nullptr) 
-{
-    type.reset(new StringType());
 }
 
 MBOPublisher::~MBOPublisher() {
-    if (writer) publisher->delete_datawriter(writer);
+    // No listener calls once the reader is gone
+    if (recovery_reader) recovery_subscriber->delete_datareader(recovery_reader);
+    if (recovery_topic) participant->delete_topic(recovery_topic);
+    if (recovery_subscriber) participant->delete_subscriber(recovery_subscriber);
+    if (writer) {
+        flush();
+        publisher->delete_datawriter(writer);
+    }
     if (topic) participant->delete_topic(topic);
     if (publisher) participant->delete_publisher(publisher);
     if (participant) {
+        participant->unregister_content_filter_factory(kInstrumentFilterClass);
         eprosima::fastdds::dds::DomainParticipantFactory::get_instance()->delete_participant(participant);
     }
 }
@@ -74,6 +69,11 @@ bool MBOPublisher::init() {
     // Register the type
     type.register_type(participant);
 
+    if (participant->register_content_filter_factory(kInstrumentFilterClass, &filter_factory) != ReturnCode_t::RETCODE_OK) {
+        std::cerr << "Failed to register instrument filter" << std::endl;
+        return false;
+    }
+
     publisher = participant->create_publisher(PUBLISHER_QOS_DEFAULT, nullptr);
     if (!publisher) {
         std::cerr << "Failed to create publisher" << std::endl;
@@ -81,7 +81,8 @@ bool MBOPublisher::init() {
     }
 
     TopicQos tqos = TOPIC_QOS_DEFAULT;
-    topic = participant->create_topic("MBOTopic", type.get_type_name(), tqos);
+    const char* topic_name = config.batch_size > 1 ? kBatchTopicName : "MBOTopic";
+    topic = participant->create_topic(topic_name, type.get_type_name(), tqos);
     if (!topic) {
         std::cerr << "Failed to create topic" << std::endl;
         return false;
@@ -89,36 +90,247 @@ bool MBOPublisher::init() {
 
     DataWriterQos wqos = DATAWRITER_QOS_DEFAULT;
     wqos.reliability().kind = RELIABLE_RELIABILITY_QOS;
-    
+    // Share sample memory with subscribers on the same host
+    wqos.data_sharing().automatic();
+    // The topic is keyed per instrument; don't cap how many there are
+    // (0 = unlimited)
+    wqos.resource_limits().max_instances = 0;
+
     writer = publisher->create_datawriter(topic, wqos, nullptr);
     if (!writer) {
         std::cerr << "Failed to create datawriter" << std::endl;
         return false;
     }
 
+    recovery_type.register_type(participant);
+    recovery_subscriber = participant->create_subscriber(SUBSCRIBER_QOS_DEFAULT, nullptr);
+    if (!recovery_subscriber) {
+        std::cerr << "Failed to create recovery subscriber" << std::endl;
+        return false;
+    }
+    recovery_topic = participant->create_topic(kRecoveryTopicName, recovery_type.get_type_name(), TOPIC_QOS_DEFAULT);
+    if (!recovery_topic) {
+        std::cerr << "Failed to create recovery topic" << std::endl;
+        return false;
+    }
+    DataReaderQos rqos = DATAREADER_QOS_DEFAULT;
+    rqos.reliability().kind = RELIABLE_RELIABILITY_QOS;
+    recovery_reader = recovery_subscriber->create_datareader(recovery_topic, rqos, this);
+    if (!recovery_reader) {
+        std::cerr << "Failed to create recovery datareader" << std::endl;
+        return false;
+    }
+
     std::cout << "DDS Publisher initialized successfully" << std::endl;
     return true;
 }
 
+const eprosima::fastdds::dds::InstanceHandle_t& MBOPublisher::instanceFor(uint32_t instrument_id, void* sample) {
+    auto it = instances.find(instrument_id);
+    if (it == instances.end()) {
+        it = instances.emplace(instrument_id, writer->register_instance(sample)).first;
+    }
+    return it->second;
+}
+
+void MBOPublisher::beginSession() {
+    std::lock_guard<std::mutex> lock(feed_mutex);
+    // Nothing from the old session may trail into the new one
+    if (faults) {
+        faults->flush([this](const MBOWire& wire) { send(wire); });
+    }
+    writeBatch();
+
+    if (++feed_session == 0) {
+        // 0 marks an unsequenced feed
+        feed_session = 1;
+    }
+    for (auto& entry : feeds) {
+        entry.second.next_sequence = 1;
+        entry.second.history.clear();
+    }
+}
+
+MBOPublisher::InstrumentFeed& MBOPublisher::feedFor(uint32_t instrument_id) {
+    if (last_feed && last_instrument == instrument_id) {
+        return *last_feed;
+    }
+    auto it = feeds.find(instrument_id);
+    if (it == feeds.end()) {
+        it = feeds.emplace(instrument_id, InstrumentFeed(config.retransmit_depth)).first;
+        stats->instruments.set(feeds.size());
+    }
+    last_instrument = instrument_id;
+    last_feed = &it->second;
+    return *last_feed;
+}
+
 void MBOPublisher::publish(const MBOParsed& record) {
-    // Convert MBOParsed to string (CSV format)
-    std::ostringstream oss;
-    oss << record.ts_event_str << "," 
-        << int(record.rtype) << "," 
-        << record.publisher_id << "," 
-        << record.instrument_id << "," 
-        << record.action << "," 
-        << record.side << "," 
-        << record.price << "," 
-        << record.size << "," 
-        << int(record.channel_id) << "," 
-        << record.order_id << "," 
-        << int(record.flags) << "," 
-        << record.ts_in_delta << "," 
-        << record.sequence << "," 
-        << record.symbol << "," 
-        << record.datetime;
-
-    std::string message = oss.str();
-    writer->write(&message);
-}
\ No newline at end of file
+    stats->records_out.add();
+    stats->actions[statsAction(record.action)].add();
+
+    MBOWire wire = toWire(record);
+    std::lock_guard<std::mutex> lock(feed_mutex);
+    InstrumentFeed& feed = feedFor(record.instrument_id);
+    wire.feed_session = feed_session;
+    wire.feed_sequence = feed.next_sequence++;
+    feed.history.store(wire);
+
+    if (faults) {
+        faults->push(wire, [this](const MBOWire& out) { send(out); });
+    } else {
+        send(wire);
+    }
+}
+
+void MBOPublisher::send(const MBOWire& wire) {
+    // Stamped on every send, resends included, so a subscriber's tick-to-
+    // book latency covers this hop and not how long the record was held.
+    // A batched record's stamp is taken as it joins the batch.
+    const uint64_t ts_send = monotonicNowNs();
+
+    if (config.batch_size > 1) {
+        // A batch holds one instrument, and a record never waits past the
+        // deadline for it to fill
+        if (batch && (batch->header.instrument_id != wire.instrument_id ||
+                      clock_type::now() - batch_started >= config.batch_deadline)) {
+            writeBatch();
+        }
+        if (!batch) {
+            startBatch(wire);
+        }
+        MBOWire& out = batch->records[batch->header.count++];
+        out = wire;
+        out.ts_send = ts_send;
+        if (batch->header.count == config.batch_size) {
+            writeBatch();
+        }
+        return;
+    }
+
+    // Write straight into a loaned sample when data-sharing is available
+    void* sample = nullptr;
+    ReturnCode_t written;
+    if (writer->loan_sample(sample) == ReturnCode_t::RETCODE_OK) {
+        MBOWire* out = static_cast<MBOWire*>(sample);
+        *out = wire;
+        out->ts_send = ts_send;
+        // Passing the registered handle saves FastDDS hashing the key per write
+        written = writer->write(sample, instanceFor(wire.instrument_id, sample));
+        if (written != ReturnCode_t::RETCODE_OK) {
+            // A loan that wasn't written stays ours to give back
+            writer->discard_loan(sample);
+        }
+    } else {
+        MBOWire copy = wire;
+        copy.ts_send = ts_send;
+        written = writer->write(&copy, instanceFor(wire.instrument_id, &copy));
+    }
+    if (written == ReturnCode_t::RETCODE_OK) {
+        stats->samples_out.add();
+    }
+}
+
+void MBOPublisher::on_data_available(eprosima::fastdds::dds::DataReader* reader) {
+    eprosima::fastdds::dds::LoanableSequence<MBORecoveryRequest> samples;
+    eprosima::fastdds::dds::SampleInfoSeq infos;
+
+    while (reader->take(samples, infos) == ReturnCode_t::RETCODE_OK) {
+        for (eprosima::fastdds::dds::LoanableCollection::size_type i = 0; i < infos.length(); ++i) {
+            if (infos[i].valid_data) {
+                resend(samples[i]);
+            }
+        }
+        reader->return_loan(samples, infos);
+    }
+}
+
+void MBOPublisher::resend(const MBORecoveryRequest& request) {
+    std::lock_guard<std::mutex> lock(feed_mutex);
+    stats->recovery_requests.add();
+    auto it = feeds.find(request.instrument_id);
+    if (request.feed_session != feed_session || it == feeds.end() || request.from_sequence > request.to_sequence) {
+        // Asked about an earlier session: the subscriber resets when it
+        // sees the current one
+        return;
+    }
+
+    const RetransmitBuffer& history = it->second.history;
+    const uint32_t to = std::min(request.to_sequence, history.last());
+    for (uint32_t sequence = request.from_sequence; sequence <= to; ++sequence) {
+        const MBOWire* wire = history.find(sequence);
+        if (!wire) {
+            stats->recovery_misses.add();
+            continue;
+        }
+        send(*wire);
+        stats->records_resent.add();
+    }
+    writeBatch();
+}
+
+void MBOPublisher::printStats(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(feed_mutex);
+    out << "Feed session " << feed_session << ": " << stats->recovery_requests.get() << " recovery requests, "
+        << stats->records_resent.get() << " records resent, " << stats->recovery_misses.get() << " no longer held";
+    if (faults) {
+        out << "; injected " << faults->dropped() << " drops, " << faults->reordered() << " reorders";
+    }
+    out << std::endl;
+}
+
+void MBOPublisher::startBatch(const MBOWire& wire) {
+    void* sample = nullptr;
+    batch_loaned = writer->loan_sample(sample) == ReturnCode_t::RETCODE_OK;
+    batch = batch_loaned ? static_cast<MBOBatch*>(sample) : batch_storage.get();
+    batch_started = clock_type::now();
+
+    std::memset(&batch->header, 0, sizeof(batch->header));
+    batch->header.first_sequence = wire.feed_sequence;
+    batch->header.instrument_id = wire.instrument_id;
+    std::memcpy(batch->header.symbol, wire.symbol, kSymbolLen);
+}
+
+void MBOPublisher::flush() {
+    std::lock_guard<std::mutex> lock(feed_mutex);
+    writeBatch();
+}
+
+void MBOPublisher::writeBatch() {
+    if (!batch) {
+        return;
+    }
+    if (writer->write(batch, instanceFor(batch->header.instrument_id, batch)) == ReturnCode_t::RETCODE_OK) {
+        stats->samples_out.add();
+    } else if (batch_loaned) {
+        void* sample = batch;
+        writer->discard_loan(sample);
+    }
+    batch = nullptr;
+    batch_loaned = false;
+}
+
+void MBOPublisher::idle(std::chrono::nanoseconds gap) {
+    std::lock_guard<std::mutex> lock(feed_mutex);
+    if (batch && clock_type::now() + gap >= batch_started + config.batch_deadline) {
+        writeBatch();
+    }
+    if (gap >= kHeartbeatGap) {
+        sendHeartbeat();
+    }
+}
+
+void MBOPublisher::heartbeat() {
+    std::lock_guard<std::mutex> lock(feed_mutex);
+    sendHeartbeat();
+}
+
+void MBOPublisher::sendHeartbeat() {
+    for (const auto& entry : feeds) {
+        const RetransmitBuffer& history = entry.second.history;
+        if (const MBOWire* wire = history.find(history.last())) {
+            send(*wire);
+        }
+    }
+    writeBatch();
+}
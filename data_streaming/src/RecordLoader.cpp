@@ -0,0 +1,173 @@
+#include "RecordLoader.hpp"
+#include "CsvParser.hpp"
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Pages behind the loader are released in chunks of this size
+constexpr size_t kReleaseChunk = 32 << 20;
+
+bool hasSuffix(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+RecordLoader::RecordLoader(size_t prefetch)
+    : is_dbn_(false), fd_(-1), map_(nullptr), map_size_(0), ring_(prefetch), running_(false),
+      pass_(1), pass_requested_(1), pass_loaded_(0),
+      stats_(&local_stats_) {
+}
+
+RecordLoader::~RecordLoader() {
+    running_.store(false, std::memory_order_release);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (map_) {
+        munmap(map_, map_size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool RecordLoader::open(const std::string& path) {
+    is_dbn_ = hasSuffix(path, ".dbn");
+    if (is_dbn_) {
+        if (!dbn_.open(path, false)) {
+            return false;
+        }
+    } else {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            std::cerr << "Error: Could not open " << path << std::endl;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd_, &st) != 0 || st.st_size == 0) {
+            std::cerr << "Error: " << path << " is empty" << std::endl;
+            return false;
+        }
+        map_size_ = static_cast<size_t>(st.st_size);
+        map_ = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (map_ == MAP_FAILED) {
+            map_ = nullptr;
+            std::cerr << "Error: Could not mmap " << path << std::endl;
+            return false;
+        }
+        madvise(map_, map_size_, MADV_SEQUENTIAL);
+    }
+
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&RecordLoader::run, this);
+    return true;
+}
+
+bool RecordLoader::next(MBOParsed& record) {
+    while (!ring_.tryPop(record)) {
+        // Everything of the pass was queued before pass_loaded_ moved, so
+        // one more look at the ring settles it
+        if (pass_loaded_.load(std::memory_order_acquire) >= pass_) {
+            return ring_.tryPop(record);
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+void RecordLoader::rewind() {
+    pass_requested_.store(++pass_, std::memory_order_release);
+}
+
+void RecordLoader::run() {
+    uint64_t pass = 1;
+    while (running_.load(std::memory_order_acquire)) {
+        if (is_dbn_) {
+            loadDbn();
+        } else {
+            loadCsv();
+        }
+        pass_loaded_.store(pass, std::memory_order_release);
+
+        // Wait for the consumer to ask for the next pass
+        while (running_.load(std::memory_order_acquire) &&
+               pass_requested_.load(std::memory_order_acquire) <= pass) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        ++pass;
+    }
+}
+
+bool RecordLoader::push(const MBOParsed& record) {
+    while (!ring_.tryPush(record)) {
+        if (!running_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    stats_->records_in.add();
+    return true;
+}
+
+void RecordLoader::loadDbn() {
+    MBOParsed record;
+    const char* released = nullptr;
+    for (const DbnMboMsg& msg : dbn_) {
+        const char* pos = reinterpret_cast<const char*>(&msg);
+        if (!released) {
+            released = pos;
+        }
+        dbn_.toParsed(msg, record);
+        if (!push(record)) {
+            return;
+        }
+        if (pos - released >= static_cast<ptrdiff_t>(kReleaseChunk)) {
+            released = release(released, pos);
+        }
+    }
+}
+
+void RecordLoader::loadCsv() {
+    const char* data = static_cast<const char*>(map_);
+    CsvScanner scanner(data, data + map_size_);
+    const char* released = data;
+
+    CsvLine line;
+    scanner.next(line);     // header
+
+    MBOParsed record;
+    while (scanner.next(line)) {
+        if (line.end > line.begin) {
+            if (parseCSVFields(line, record)) {
+                if (!push(record)) {
+                    return;
+                }
+            } else {
+                stats_->parse_errors.add();
+            }
+        }
+
+        if (scanner.position() - released >= static_cast<ptrdiff_t>(kReleaseChunk)) {
+            released = release(released, scanner.position());
+        }
+    }
+}
+
+const char* RecordLoader::release(const char* from, const char* to) {
+    static const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(from) & ~(page - 1);
+    const uintptr_t end = reinterpret_cast<uintptr_t>(to) & ~(page - 1);
+    if (end <= begin) {
+        return from;
+    }
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+    return reinterpret_cast<const char*>(end);
+}
@@ -0,0 +1,144 @@
+#include "ReplayScheduler.hpp"
+#include <iomanip>
+#include <thread>
+
+namespace {
+
+// Closer to the deadline than this, spin instead of sleeping; OS sleeps
+// overshoot by 50-100us
+constexpr auto kSpinThreshold = std::chrono::microseconds(200);
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+} // namespace
+
+bool ReplayConfig::parse(const std::string& spec, ReplayConfig& out) {
+    try {
+        if (spec == "realtime") {
+            out.mode = ReplayMode::RealTime;
+            return true;
+        }
+        if (spec == "max") {
+            out.mode = ReplayMode::Max;
+            return true;
+        }
+        if (spec.compare(0, 6, "speed:") == 0) {
+            out.mode = ReplayMode::Speed;
+            out.speed = std::stod(spec.substr(6));
+            return out.speed > 0.0;
+        }
+        if (spec.compare(0, 5, "rate:") == 0) {
+            out.mode = ReplayMode::FixedRate;
+            out.rate = std::stod(spec.substr(5));
+            return out.rate > 0.0;
+        }
+    } catch (const std::exception&) {
+    }
+    return false;
+}
+
+ReplayScheduler::ReplayScheduler(const ReplayConfig& config)
+    : config_(config), interval_(0), pass_(0), records_(0), first_ts_(0), last_ts_(0) {
+    if (config_.mode == ReplayMode::RealTime) {
+        config_.speed = 1.0;
+    }
+    if (config_.mode == ReplayMode::FixedRate) {
+        interval_ = std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(1.0 / config_.rate));
+    }
+}
+
+void ReplayScheduler::beginPass() {
+    ++pass_;
+    records_ = 0;
+    first_ts_ = 0;
+    last_ts_ = 0;
+    lateness_.reset();
+    start_ = clock_type::now();
+}
+
+ReplayScheduler::clock_type::time_point ReplayScheduler::dueTime(uint64_t ts_event) {
+    switch (config_.mode) {
+    case ReplayMode::RealTime:
+    case ReplayMode::Speed: {
+        if (records_ == 0) {
+            return start_;
+        }
+        // Out-of-order ts_event is sent right away rather than rewinding
+        const uint64_t ts = ts_event > last_ts_ ? ts_event : last_ts_;
+        const double offset_ns = double(ts - first_ts_) / config_.speed;
+        return start_ + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double, std::nano>(offset_ns));
+    }
+    case ReplayMode::FixedRate:
+        return start_ + interval_ * static_cast<int64_t>(records_);
+    case ReplayMode::Max:
+        break;
+    }
+    return start_;
+}
+
+std::chrono::nanoseconds ReplayScheduler::untilDue(uint64_t ts_event) {
+    if (config_.mode == ReplayMode::Max) {
+        return std::chrono::nanoseconds(0);
+    }
+    const auto remaining = dueTime(ts_event) - clock_type::now();
+    return remaining > clock_type::duration::zero()
+        ? std::chrono::duration_cast<std::chrono::nanoseconds>(remaining)
+        : std::chrono::nanoseconds(0);
+}
+
+void ReplayScheduler::waitFor(uint64_t ts_event) {
+    if (config_.mode != ReplayMode::Max) {
+        const clock_type::time_point due = dueTime(ts_event);
+        clock_type::time_point now = clock_type::now();
+        if (due - now > kSpinThreshold) {
+            std::this_thread::sleep_for(due - now - kSpinThreshold);
+            now = clock_type::now();
+        }
+        while (now < due) {
+            cpuRelax();
+            now = clock_type::now();
+        }
+        lateness_.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - due).count()));
+    }
+
+    if (records_ == 0) {
+        first_ts_ = ts_event;
+    }
+    if (ts_event > last_ts_) {
+        last_ts_ = ts_event;
+    }
+    ++records_;
+}
+
+void ReplayScheduler::endPass(std::ostream& out) {
+    const double secs = std::chrono::duration<double>(clock_type::now() - start_).count();
+    const double achieved = secs > 0.0 ? double(records_) / secs : 0.0;
+
+    out << "Pass " << pass_ << ": " << records_ << " records in " << std::fixed << std::setprecision(3)
+        << secs << " s, " << std::setprecision(0) << achieved << " msg/s";
+
+    double target = 0.0;
+    if (config_.mode == ReplayMode::FixedRate) {
+        target = config_.rate;
+    } else if (config_.mode != ReplayMode::Max && last_ts_ > first_ts_) {
+        target = double(records_) / (double(last_ts_ - first_ts_) / 1e9 / config_.speed);
+    }
+    if (target > 0.0) {
+        out << " (target " << target << " msg/s)";
+    }
+    out << std::endl;
+
+    if (lateness_.count() > 0) {
+        out << "  Lateness ns: p50 " << lateness_.percentile(0.50)
+            << ", p90 " << lateness_.percentile(0.90)
+            << ", p99 " << lateness_.percentile(0.99)
+            << ", p99.9 " << lateness_.percentile(0.999)
+            << ", max " << lateness_.max() << std::endl;
+    }
+}
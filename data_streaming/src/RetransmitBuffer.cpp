@@ -0,0 +1,44 @@
+#include "RetransmitBuffer.hpp"
+
+RetransmitBuffer::RetransmitBuffer(size_t depth)
+    : mask_(0), first_(1), last_(0) {
+    size_t size = 1;
+    while (size < depth) {
+        size <<= 1;
+    }
+    mask_ = size - 1;
+}
+
+void RetransmitBuffer::store(const MBOWire& wire) {
+    if (last_ >= first_ && wire.feed_sequence != last_ + 1) {
+        // Not a continuation: start over from this record
+        clear();
+    }
+    if (last_ < first_) {
+        first_ = wire.feed_sequence;
+    }
+    last_ = wire.feed_sequence;
+
+    const size_t index = wire.feed_sequence & mask_;
+    if (index >= slots_.size()) {
+        // Still growing towards the full depth
+        slots_.resize(index + 1);
+    }
+    slots_[index] = wire;
+    if (last_ - first_ > mask_) {
+        ++first_;
+    }
+}
+
+const MBOWire* RetransmitBuffer::find(uint32_t sequence) const {
+    if (sequence < first_ || sequence > last_) {
+        return nullptr;
+    }
+    return &slots_[sequence & mask_];
+}
+
+void RetransmitBuffer::clear() {
+    slots_.clear();
+    first_ = 1;
+    last_ = 0;
+}
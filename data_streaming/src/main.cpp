@@ -1,112 +1,137 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <iomanip>
 #include <string>
-#include <vector>
 #include <cstdint>
-#include <thread>
 #include <chrono>
 
 #include "MBOParsed.hpp"
 #include "MBOPublisher.hpp"
-
-MBOParsed parseCSVLine(const std::string& line) {
-    MBOParsed record{};
-    std::stringstream ss(line);
-    std::string field;
-    std::vector<std::string> fields;
-    
-    // Split by comma
-    while (std::getline(ss, field, ',')) {
-        fields.push_back(field);
-    }
-    
-    if (fields.size() >= 15) {
-        record.ts_event_str = fields[0];
-        record.rtype = static_cast<uint8_t>(std::stoi(fields[1]));
-        record.publisher_id = static_cast<uint16_t>(std::stoi(fields[2]));
-        record.instrument_id = static_cast<uint32_t>(std::stoul(fields[3]));
-        record.action = fields[4][0];
-        record.side = fields[5][0];
-        record.price = std::stod(fields[6]);
-        record.size = static_cast<uint32_t>(std::stoul(fields[7]));
-        record.channel_id = static_cast<uint8_t>(std::stoi(fields[8]));
-        record.order_id = std::stoull(fields[9]);
-        record.flags = static_cast<uint8_t>(std::stoi(fields[10]));
-        record.ts_in_delta = std::stoi(fields[11]);
-        record.sequence = static_cast<uint32_t>(std::stoul(fields[12]));
-        record.symbol = fields[13];
-        record.datetime = fields[14];
-    }
-    
-    return record;
+#include "RecordLoader.hpp"
+#include "ReplayScheduler.hpp"
+#include "StatsSegment.hpp"
+
+void printUsage(const char* prog) {
+    std::cout << "Usage: " << prog << " [options] [FILE]\n"
+              << "  FILE              Databento .dbn file or exported CSV (default: ./data.csv)\n"
+              << "  --replay SPEC     realtime | speed:X | rate:N | max (default: realtime)\n"
+              << "  --batch K         pack up to K records of one instrument per sample (max "
+              << kMaxBatchRecords << ", default: 1 = unbatched)\n"
+              << "  --batch-deadline US\n"
+              << "                    longest a record waits for its batch to fill (default: "
+              << kDefaultBatchDeadline.count() << ")\n"
+              << "  --retransmit-depth N\n"
+              << "                    records per instrument kept for recovery requests (default: "
+              << kDefaultRetransmitDepth << ")\n"
+              << "  --faults SPEC     drop:P,reorder:P,depth:N,seed:S - drop and reorder outgoing\n"
+              << "                    records to exercise subscriber recovery (default: off)\n"
+              << "  --stats-name NAME live counters in /dev/shm/mbo_stats.NAME, read with mbo_stat;\n"
+              << "                    none = don't publish them (default: " << kPublisherStatsName << ")\n";
 }
 
-void printRecord(const MBOParsed& r) {
-    std::cout << std::fixed << std::setprecision(2)
-              << "ts_event=" << r.ts_event_str
-              << " rtype=" << int(r.rtype)
-              << " publisher_id=" << r.publisher_id
-              << " instrument_id=" << r.instrument_id
-              << " action=" << r.action
-              << " side=" << r.side
-              << " price=" << r.price
-              << " size=" << r.size
-              << " channel_id=" << int(r.channel_id)
-              << " order_id=" << r.order_id
-              << " flags=" << int(r.flags)
-              << " ts_in_delta=" << r.ts_in_delta
-              << " sequence=" << r.sequence
-              << " symbol=" << r.symbol
-              << " datetime=" << r.datetime
-              << std::endl;
-}
-
-
-int main() {
+int main(int argc, char** argv) {
     try {
-        std::ifstream file("./data.csv");
-        if (!file.is_open()) {
-            std::cerr << "Error: Could not open data.csv" << std::endl;
-            return 1;
-        }
-
-        std::string line;
-        std::vector<MBOParsed> records;
-
-        std::getline(file, line); // skip header
-        while (std::getline(file, line)) {
-            if (!line.empty()) {
-                records.push_back(parseCSVLine(line));
+        // Input: a raw Databento .dbn file or the exported CSV
+        std::string input_path = "./data.csv";
+        PublisherConfig config;
+        ReplayConfig replay_config;
+        std::string stats_name = kPublisherStatsName;
+
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--replay" && i + 1 < argc) {
+                if (!ReplayConfig::parse(argv[++i], replay_config)) {
+                    std::cerr << "Invalid replay mode: " << argv[i] << std::endl;
+                    return 1;
+                }
+            } else if (arg == "--batch" && i + 1 < argc) {
+                config.batch_size = std::stoull(argv[++i]);
+                if (config.batch_size == 0 || config.batch_size > kMaxBatchRecords) {
+                    std::cerr << "Invalid batch size: " << argv[i] << std::endl;
+                    return 1;
+                }
+            } else if (arg == "--batch-deadline" && i + 1 < argc) {
+                config.batch_deadline = std::chrono::microseconds(std::stoull(argv[++i]));
+            } else if (arg == "--retransmit-depth" && i + 1 < argc) {
+                config.retransmit_depth = std::stoull(argv[++i]);
+                if (config.retransmit_depth == 0) {
+                    std::cerr << "Invalid retransmit depth: " << argv[i] << std::endl;
+                    return 1;
+                }
+            } else if (arg == "--faults" && i + 1 < argc) {
+                if (!FaultConfig::parse(argv[++i], config.faults)) {
+                    std::cerr << "Invalid fault spec: " << argv[i] << std::endl;
+                    return 1;
+                }
+            } else if (arg == "--stats-name" && i + 1 < argc) {
+                stats_name = argv[++i];
+                if (stats_name == "none") {
+                    stats_name.clear();
+                } else if (stats_name.empty() || stats_name.find('/') != std::string::npos) {
+                    std::cerr << "Invalid stats segment name: " << argv[i] << std::endl;
+                    return 1;
+                }
+            } else if (arg == "-h" || arg == "--help") {
+                printUsage(argv[0]);
+                return 0;
+            } else if (arg.compare(0, 2, "--") == 0) {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            } else {
+                input_path = arg;
             }
         }
-        file.close();
+        // Live counters for mbo_stat; without the segment they stay in
+        // process. Declared first: the loader thread writes into it.
+        StatsSegment stats;
+        if (!stats_name.empty() && stats.create(stats_name, StatsService::Publisher, 0)) {
+            std::cout << "Live stats in " << StatsSegment::path(stats_name) << std::endl;
+        }
 
-        std::cout << "Total records loaded: " << records.size() << std::endl;
+        // Records are parsed ahead on the loader thread while DDS starts up
+        RecordLoader loader;
+        if (stats.isOpen()) {
+            loader.setStats(&stats.publisher());
+        }
+        if (!loader.open(input_path)) {
+            return 1;
+        }
+        if (loader.isDbn()) {
+            std::cout << "Mapped DBN file: " << input_path
+                      << " (" << loader.dbn().metadata().dataset << ")" << std::endl;
+        } else {
+            std::cout << "Mapped CSV file: " << input_path << std::endl;
+        }
 
         // Init DDS publisher
-        MBOPublisher publisher;
+        MBOPublisher publisher(config);
+        if (stats.isOpen()) {
+            publisher.setStats(&stats.publisher());
+        }
         if (!publisher.init()) {
             std::cerr << "Failed to initialize DDS publisher" << std::endl;
             return 1;
         }
 
-        size_t i = 0;
+        ReplayScheduler scheduler(replay_config);
+        MBOParsed record;
         while (true) {  // infinite replay loop
-            if (records[i].ts_in_delta > 0) {
-                std::cout << "Sleeping for " << records[i].ts_in_delta << " microseconds" << std::endl;
-                std::this_thread::sleep_for(std::chrono::microseconds(records[i].ts_in_delta));
+            // Each pass is a new feed session: subscribers start their books over
+            publisher.beginSession();
+            scheduler.beginPass();
+            while (loader.next(record)) {
+                // Don't hold a partial batch across the gap
+                publisher.idle(scheduler.untilDue(record.ts_event));
+                scheduler.waitFor(record.ts_event);
+                publisher.publish(record);
             }
-
-            printRecord(records[i]);
-            publisher.publish(records[i]);
-
-            i++;
-            if (i >= records.size()) {
-                std::cout << "\nReached end of records — restarting from beginning.\n" << std::endl;
-                i = 0; // restart from first record
+            publisher.heartbeat();
+            scheduler.endPass(std::cout);
+            publisher.printStats(std::cout);
+            if (loader.malformed() > 0) {
+                std::cout << "Skipped " << loader.malformed() << " malformed CSV lines" << std::endl;
             }
+            loader.rewind();
+            std::cout << "\nReached end of records — restarting from beginning.\n" << std::endl;
         }
 
     } catch (const std::exception& e) {
@@ -116,6 +141,3 @@ int main() {
 
     return 0;
 }
-
-
-
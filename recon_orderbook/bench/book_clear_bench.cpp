@@ -0,0 +1,222 @@
+// Checks and times the 'R' (clear book) action. For each book layout, a
+// DBN MBO file is replayed with a clear injected halfway through: the
+// book must be empty straight after it, and at the end must match a fresh
+// book fed only the records after the clear. Then books of 100K and 1M
+// synthetic orders are cleared, against tearing the same book down one
+// cancel at a time, counting heap allocations along the way.
+//
+//   book_clear_bench [FILE] [PASSES]
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "DbnReader.hpp"
+#include "LatencyHistogram.hpp"
+#include "OrderBookManager.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+// Counting allocator: every global operator new bumps this
+std::atomic<uint64_t> g_heap_allocations{0};
+
+uint64_t elapsedNs(clock_type::time_point t0, clock_type::time_point t1) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+}
+
+uint64_t allocations() {
+    return g_heap_allocations.load(std::memory_order_relaxed);
+}
+
+const char* layoutName(BookLayout layout) {
+    return layout == BookLayout::Ladder ? "ladder" : "sorted";
+}
+
+bool sameBook(const OrderBookManager& a, const OrderBookManager& b) {
+    std::vector<BookLevel> a_bids, a_asks, b_bids, b_asks;
+    a.getDepth(SIZE_MAX, a_bids, a_asks);
+    b.getDepth(SIZE_MAX, b_bids, b_asks);
+    auto same = [](const std::vector<BookLevel>& x, const std::vector<BookLevel>& y) {
+        if (x.size() != y.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < x.size(); ++i) {
+            if (x[i].price != y[i].price || x[i].qty != y[i].qty || x[i].orders != y[i].orders) {
+                return false;
+            }
+        }
+        return true;
+    };
+    return same(a_bids, b_bids) && same(a_asks, b_asks) && a.book().orderCount() == b.book().orderCount();
+}
+
+bool empty(const OrderBookManager& manager) {
+    std::vector<BookLevel> bids, asks;
+    manager.getDepth(SIZE_MAX, bids, asks);
+    const TopOfBook top = manager.getTopOfBook();
+    return bids.empty() && asks.empty() && top.bid.orders == 0 && top.ask.orders == 0 &&
+           manager.book().orderCount() == 0 && manager.pendingCancels().size() == 0;
+}
+
+// Replay with a clear at the midpoint; false if the book state is wrong
+bool replayWithClear(BookLayout layout, const TickSize& tick, const std::vector<MBOParsed>& records, int passes) {
+    const size_t mid = records.size() / 2;
+    MBOParsed clear = records[mid];
+    clear.action = 'R';
+    clear.side = 'N';
+    clear.order_id = 0;
+    clear.price = 0;
+    clear.size = 0;
+
+    OrderBookManager reference(kDefaultMaxOrders, kDefaultMaxPendingCancels, 0, layout);
+    reference.setTickSize(tick);
+    for (size_t i = mid; i < records.size(); ++i) {
+        reference.applyMessage(records[i]);
+    }
+
+    LatencyHistogram clear_ns;
+    size_t orders_before = 0, levels_before = 0;
+    uint64_t clear_allocations = 0;
+    bool ok = true;
+    for (int pass = 0; pass < passes && ok; ++pass) {
+        OrderBookManager manager(kDefaultMaxOrders, kDefaultMaxPendingCancels, 0, layout);
+        manager.setTickSize(tick);
+        for (size_t i = 0; i < mid; ++i) {
+            manager.applyMessage(records[i]);
+        }
+        orders_before = manager.book().orderCount();
+        levels_before = manager.book().bids().levelCount() + manager.book().asks().levelCount();
+
+        const uint64_t allocs_before = allocations();
+        const auto t0 = clock_type::now();
+        manager.applyMessage(clear);
+        const auto t1 = clock_type::now();
+        clear_allocations += allocations() - allocs_before;
+        clear_ns.record(elapsedNs(t0, t1));
+
+        if (!empty(manager)) {
+            std::cout << "  book not empty after the clear" << std::endl;
+            ok = false;
+        }
+        for (size_t i = mid; i < records.size(); ++i) {
+            manager.applyMessage(records[i]);
+        }
+        if (!sameBook(manager, reference)) {
+            std::cout << "  book after the clear differs from a fresh replay" << std::endl;
+            ok = false;
+        }
+    }
+
+    std::cout << layoutName(layout) << ": " << (ok ? "PASS" : "FAIL") << ", clear of " << orders_before
+              << " orders on " << levels_before << " levels: p50 " << clear_ns.percentile(0.50) << " ns, max "
+              << clear_ns.max() << " ns, " << clear_allocations << " heap allocations" << std::endl;
+    return ok;
+}
+
+// A book of orders spread over levels_per_side levels of each side
+void fill(MBOBook& book, size_t orders, size_t levels_per_side) {
+    for (size_t i = 0; i < orders; ++i) {
+        const bool is_buy = i % 2 == 0;
+        const int64_t offset = static_cast<int64_t>((i / 2) % levels_per_side);
+        book.add(i + 1, is_buy, is_buy ? 10000 - offset : 10001 + offset, 1 + i % 10, i);
+    }
+}
+
+void clearLargeBook(BookLayout layout, size_t orders) {
+    constexpr size_t kLevelsPerSide = 2000;
+
+    MBOBook book(orders, layout);
+    fill(book, orders, kLevelsPerSide);
+    uint64_t allocs_before = allocations();
+    auto t0 = clock_type::now();
+    book.clear();
+    auto t1 = clock_type::now();
+    const uint64_t clear_allocations = allocations() - allocs_before;
+
+    // The cleared book takes the same orders again without growing
+    const size_t slabs = book.orderPool().slabCount();
+    allocs_before = allocations();
+    fill(book, orders, kLevelsPerSide);
+    const uint64_t refill_allocations = allocations() - allocs_before;
+    const bool reused = book.orderPool().slabCount() == slabs && book.orderCount() == orders;
+
+    // The same book torn down order by order
+    auto t2 = clock_type::now();
+    for (size_t i = 0; i < orders; ++i) {
+        book.cancel(i + 1, 0);
+    }
+    auto t3 = clock_type::now();
+
+    std::cout << "  " << layoutName(layout) << std::setw(9) << orders << " orders: clear "
+              << std::fixed << std::setprecision(1) << std::setw(8) << elapsedNs(t0, t1) / 1000.0 << " us ("
+              << clear_allocations << " allocations), cancel one by one " << std::setw(8)
+              << elapsedNs(t2, t3) / 1000.0 << " us; refill " << (reused ? "reused the pools" : "grew the pools")
+              << " (" << refill_allocations << " allocations)" << std::endl;
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    const size_t alignment = static_cast<size_t>(align);
+    if (void* ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "../data_analyze/CLX5_mbo (2).dbn";
+    const int passes = argc > 2 ? std::stoi(argv[2]) : 20;
+
+    DbnReader reader;
+    if (!reader.open(path)) {
+        return 1;
+    }
+    std::vector<MBOParsed> records;
+    MBOParsed record;
+    for (const DbnMboMsg& msg : reader) {
+        reader.toParsed(msg, record);
+        records.push_back(record);
+    }
+    if (records.empty()) {
+        std::cerr << "No records in " << path << std::endl;
+        return 1;
+    }
+
+    // Single-instrument replay on CL's 0.01 grid, so the ladder is exercised
+    InstrumentTable instruments;
+    instruments.add("CL*", kPriceScale / 100);
+    const TickSize tick = instruments.lookup(records.front().instrument_id, records.front().symbol);
+    std::cout << "Replaying " << records.size() << " records x " << passes << " passes, clear after record "
+              << records.size() / 2 << std::endl;
+
+    bool ok = replayWithClear(BookLayout::Sorted, tick, records, passes);
+    ok = replayWithClear(BookLayout::Ladder, tick, records, passes) && ok;
+
+    std::cout << "Synthetic books" << std::endl;
+    for (size_t orders : {size_t(100000), size_t(1000000)}) {
+        clearLargeBook(BookLayout::Sorted, orders);
+        clearLargeBook(BookLayout::Ladder, orders);
+    }
+    return ok ? 0 : 1;
+}
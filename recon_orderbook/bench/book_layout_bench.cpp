@@ -0,0 +1,133 @@
+// Replays a DBN MBO file through OrderBookManager once per book layout
+// (sorted array vs tick-indexed ladder) and reports per-action latency
+// percentiles for adds, cancels and modifies, plus the cost of reading
+// the best bid and ask after every message.
+//
+//   book_layout_bench [FILE] [PASSES] [DEFINITIONS]
+//
+// Tick sizes come from DEFINITIONS (default: CL*,0.01).
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DbnReader.hpp"
+#include "InstrumentTable.hpp"
+#include "LatencyHistogram.hpp"
+#include "OrderBookManager.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+// topOfBook() calls timed together per message; one is below clock resolution
+constexpr unsigned kTopReads = 64;
+
+struct LayoutStats {
+    LatencyHistogram add;
+    LatencyHistogram cancel;
+    LatencyHistogram modify;
+    LatencyHistogram top;       // per call
+};
+
+uint64_t elapsedNs(clock_type::time_point t0, clock_type::time_point t1) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+}
+
+LayoutStats run(BookLayout layout, const TickSize& tick, const std::vector<MBOParsed>& records, int passes) {
+    LayoutStats stats;
+    int64_t sink = 0;
+    for (int pass = 0; pass < passes; ++pass) {
+        // Fresh manager per pass; its pools are sized in the constructor
+        OrderBookManager manager(kDefaultMaxOrders, kDefaultMaxPendingCancels, 0, layout);
+        manager.setTickSize(tick);
+
+        for (const MBOParsed& msg : records) {
+            auto t0 = clock_type::now();
+            manager.applyMessage(msg);
+            auto t1 = clock_type::now();
+            switch (msg.action) {
+                case 'A': stats.add.record(elapsedNs(t0, t1)); break;
+                case 'C': stats.cancel.record(elapsedNs(t0, t1)); break;
+                case 'M': stats.modify.record(elapsedNs(t0, t1)); break;
+                default: break;
+            }
+
+            t0 = clock_type::now();
+            for (unsigned i = 0; i < kTopReads; ++i) {
+                const TopOfBook top = manager.getTopOfBook();
+                sink += top.bid.price - top.ask.price;
+                asm volatile("" : "+r"(sink));
+            }
+            t1 = clock_type::now();
+            stats.top.record(elapsedNs(t0, t1) / kTopReads);
+        }
+    }
+    return stats;
+}
+
+void printRow(const char* name, const LatencyHistogram& h) {
+    std::cout << "  " << std::left << std::setw(8) << name << std::right
+              << std::setw(9) << h.count()
+              << "   p50 " << std::setw(5) << h.percentile(0.50) << " ns"
+              << "   p99 " << std::setw(6) << h.percentile(0.99) << " ns"
+              << "   p99.9 " << std::setw(7) << h.percentile(0.999) << " ns"
+              << "   mean " << std::fixed << std::setprecision(1) << std::setw(7) << h.mean() << " ns" << std::endl;
+}
+
+void print(const char* name, const LayoutStats& stats) {
+    std::cout << name << std::endl;
+    printRow("add", stats.add);
+    printRow("cancel", stats.cancel);
+    printRow("modify", stats.modify);
+    printRow("top", stats.top);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "../data_analyze/CLX5_mbo (2).dbn";
+    const int passes = argc > 2 ? std::stoi(argv[2]) : 20;
+
+    InstrumentTable instruments;
+    if (argc > 3) {
+        if (!instruments.load(argv[3])) {
+            return 1;
+        }
+    } else {
+        instruments.add("CL*", kPriceScale / 100);
+    }
+
+    DbnReader reader;
+    if (!reader.open(path)) {
+        return 1;
+    }
+    std::vector<MBOParsed> records;
+    MBOParsed record;
+    for (const DbnMboMsg& msg : reader) {
+        reader.toParsed(msg, record);
+        records.push_back(record);
+    }
+    if (records.empty()) {
+        std::cerr << "No records in " << path << std::endl;
+        return 1;
+    }
+
+    // Single-instrument replay: one tick size for the whole file
+    const TickSize tick = instruments.lookup(records.front().instrument_id, records.front().symbol);
+    std::cout << "Replaying " << records.size() << " records x " << passes << " passes, tick "
+              << formatPrice(tick.tick, tick.decimals) << std::endl;
+
+    // Timer overhead, included in every figure below
+    LatencyHistogram overhead;
+    for (int i = 0; i < 100000; ++i) {
+        const auto t0 = clock_type::now();
+        overhead.record(elapsedNs(t0, clock_type::now()));
+    }
+    std::cout << "Clock overhead p50 " << overhead.percentile(0.50) << " ns" << std::endl;
+
+    print("sorted", run(BookLayout::Sorted, tick, records, passes));
+    print("ladder", run(BookLayout::Ladder, tick, records, passes));
+    return 0;
+}
@@ -0,0 +1,247 @@
+// Replays a DBN MBO file through OrderBookManager (and, when built with
+// HAVE_LIQUIBOOK, the previous Liquibook-backed engine) and reports
+// messages per second, per-message latency percentiles and the number of
+// heap allocations made while applying messages.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DbnReader.hpp"
+#include "OrderBookManager.hpp"
+
+#ifdef HAVE_LIQUIBOOK
+#include <book/depth_order_book.h>
+#include <book/order.h>
+#endif
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+// Counting allocator: every global operator new bumps this
+std::atomic<uint64_t> g_heap_allocations{0};
+
+// Optional snapshot policy: views are captured on the replay thread and
+// serialised by the writer thread into a null sink
+bool g_snapshots = false;
+SnapshotPolicy g_snapshot_policy;
+
+struct ManagerEngine {
+    static constexpr const char* name = "MBOBook";
+
+    std::unique_ptr<SnapshotWriter> writer;
+    std::unique_ptr<OrderBookManager> manager;
+
+    void apply(const MBOParsed& msg) {
+        if (g_snapshots) {
+            manager->processMessage(msg);
+        } else {
+            manager->applyMessage(msg);
+        }
+    }
+
+    // Fresh manager per pass; its pools are sized in the constructor
+    void reset() {
+        manager.reset();
+        writer = std::make_unique<SnapshotWriter>();
+        writer->addSink(std::make_unique<NullSnapshotSink>());
+        writer->start();
+        manager = std::make_unique<OrderBookManager>();
+        manager->setSnapshotPolicy(g_snapshot_policy);
+        manager->setSnapshotWriter(writer.get());
+    }
+
+    // Writer stats for the last pass
+    ~ManagerEngine() {
+        if (g_snapshots && writer) {
+            writer->stop();
+            writer->printStats(std::cout);
+        }
+    }
+
+    size_t liveOrders() const { return manager->book().orderCount(); }
+};
+
+#ifdef HAVE_LIQUIBOOK
+using namespace liquibook;
+
+class LiquibookOrder : public book::Order {
+public:
+    LiquibookOrder(bool is_buy, book::Price price, book::Quantity qty)
+        : is_buy_(is_buy), price_(price), qty_(qty) {}
+    bool is_buy() const override { return is_buy_; }
+    book::Price price() const override { return price_; }
+    book::Quantity order_qty() const override { return qty_; }
+
+private:
+    bool is_buy_;
+    book::Price price_;
+    book::Quantity qty_;
+};
+
+// The engine OrderBookManager used before MBOBook
+struct LiquibookEngine {
+    static constexpr const char* name = "Liquibook";
+
+    book::DepthOrderBook<LiquibookOrder*> book;
+    std::unordered_map<uint64_t, LiquibookOrder*> order_map;
+    std::unordered_map<uint64_t, MBOParsed> pending_cancels;
+
+    static book::Price cents(int64_t price) { return static_cast<book::Price>(price / (kPriceScale / 100)); }
+
+    void cancel(uint64_t order_id) {
+        auto it = order_map.find(order_id);
+        book.cancel(it->second);
+        delete it->second;
+        order_map.erase(it);
+    }
+
+    void apply(const MBOParsed& msg) {
+        switch (msg.action) {
+            case 'A': {
+                if (order_map.count(msg.order_id)) break;
+                auto* order = new LiquibookOrder(msg.side == 'B', cents(msg.price), msg.size);
+                book.add(order, book::oc_no_conditions);
+                order_map[msg.order_id] = order;
+                auto pending = pending_cancels.find(msg.order_id);
+                if (pending != pending_cancels.end()) {
+                    cancel(msg.order_id);
+                    pending_cancels.erase(pending);
+                }
+                break;
+            }
+            case 'C':
+                if (order_map.count(msg.order_id)) {
+                    cancel(msg.order_id);
+                } else {
+                    pending_cancels[msg.order_id] = msg;
+                }
+                break;
+            case 'M': {
+                auto it = order_map.find(msg.order_id);
+                if (it == order_map.end()) break;
+                bool is_buy = it->second->is_buy();
+                cancel(msg.order_id);
+                auto* order = new LiquibookOrder(is_buy, cents(msg.price), msg.size);
+                book.add(order, book::oc_no_conditions);
+                order_map[msg.order_id] = order;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void reset() {
+        while (!order_map.empty()) {
+            cancel(order_map.begin()->first);
+        }
+        pending_cancels.clear();
+    }
+
+    size_t liveOrders() const { return order_map.size(); }
+};
+#endif
+
+template <typename Engine>
+void run(const std::vector<MBOParsed>& records, int passes) {
+    Engine engine;
+    std::vector<uint32_t> latencies;
+    latencies.reserve(records.size() * passes);
+
+    double secs = 0.0;
+    uint64_t allocations = 0;
+    for (int pass = 0; pass < passes; ++pass) {
+        engine.reset();
+        const uint64_t allocs_before = g_heap_allocations.load(std::memory_order_relaxed);
+        auto start = clock_type::now();
+        for (const MBOParsed& msg : records) {
+            auto t0 = clock_type::now();
+            engine.apply(msg);
+            auto t1 = clock_type::now();
+            latencies.push_back(static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+        }
+        secs += std::chrono::duration<double>(clock_type::now() - start).count();
+        allocations += g_heap_allocations.load(std::memory_order_relaxed) - allocs_before;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto pct = [&latencies](double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+    };
+
+    std::cout << std::left << std::setw(10) << Engine::name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << latencies.size() / secs / 1e6 << " M msg/s"
+              << "   p50 " << std::setw(6) << pct(0.50) << " ns"
+              << "   p99 " << std::setw(6) << pct(0.99) << " ns"
+              << "   p999 " << std::setw(7) << pct(0.999) << " ns"
+              << "   heap allocs " << allocations
+              << "   live orders " << engine.liveOrders() << std::endl;
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    const size_t alignment = static_cast<size_t>(align);
+    if (void* ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "../data_analyze/CLX5_mbo (2).dbn";
+    const int passes = argc > 2 ? std::stoi(argv[2]) : 20;
+    if (argc > 3) {
+        // e.g. "every:1000", "top": measure processMessage including snapshots
+        if (!SnapshotPolicy::parse(argv[3], g_snapshot_policy)) {
+            std::cerr << "Invalid snapshot policy: " << argv[3] << std::endl;
+            return 1;
+        }
+        g_snapshots = true;
+    }
+
+    DbnReader reader;
+    if (!reader.open(path)) {
+        return 1;
+    }
+
+    std::vector<MBOParsed> records;
+    MBOParsed record;
+    for (const DbnMboMsg& msg : reader) {
+        reader.toParsed(msg, record);
+        records.push_back(record);
+    }
+    std::cout << "Replaying " << records.size() << " records x " << passes << " passes" << std::endl;
+
+    run<ManagerEngine>(records, passes);
+#ifdef HAVE_LIQUIBOOK
+    run<LiquibookEngine>(records, passes);
+#else
+    std::cout << "(Liquibook comparison skipped: run 'make setup' first)" << std::endl;
+#endif
+    return 0;
+}
@@ -0,0 +1,270 @@
+// Drives BookRegistry with a simulated publisher that stamps feed
+// sequences, loses and reorders records with FaultInjector, and answers
+// recovery requests from a bounded per-instrument history, the way
+// data_streaming does over DDS. Each scenario's final books are compared
+// with a clean replay of the same records.
+//
+//   feed_recovery_bench [FILE] [SEED]
+//
+// Scenarios: clean feed; light and heavy loss/reordering; publisher
+// restart halfway through; subscriber joining late with the history
+// covering what it missed, and with the history too short (that book has
+// to end up flagged diverged rather than silently wrong).
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "BookRegistry.hpp"
+#include "DbnReader.hpp"
+#include "FaultInjector.hpp"
+#include "MBOWire.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+// Samples the subscriber may have queued before the publisher waits: a
+// live feed arrives far slower than books apply it, and a single core
+// shared by both threads would otherwise queue the whole file at once
+constexpr size_t kMaxBacklog = 256;
+
+// No recovery request for this long means the subscriber has settled
+constexpr auto kSettleQuiet = std::chrono::milliseconds(200);
+constexpr auto kSettleLimit = std::chrono::seconds(10);
+
+// Publisher side of the feed: one session at a time, every record kept
+// (the depth limits what is resent, like RetransmitBuffer)
+class SimPublisher {
+public:
+    SimPublisher(BookRegistry& registry, const FaultConfig& faults, size_t depth)
+        : registry_(registry), faults_(faults), depth_(depth), session_(100),
+          requests_(0), resent_(0), misses_(0) {
+    }
+
+    void beginSession() {
+        faults_.flush([this](const MBOWire& wire) { registry_.dispatch(wire); });
+        ++session_;
+        history_.clear();
+    }
+
+    // Stamp and keep record; deliver it only if the subscriber is there
+    void publish(const MBOParsed& record, bool deliver) {
+        MBOWire wire = toWire(record);
+        std::vector<MBOWire>& history = history_[record.instrument_id];
+        wire.feed_session = session_;
+        wire.feed_sequence = static_cast<uint32_t>(history.size() + 1);
+        history.push_back(wire);
+        if (deliver) {
+            faults_.push(wire, [this](const MBOWire& out) { registry_.dispatch(out); });
+        }
+        serve();
+
+        const BookWorker& worker = registry_.shard(registry_.shardOf(record.instrument_id)).worker();
+        while (worker.occupancy() > kMaxBacklog) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Answer whatever recovery requests are queued; true if there were any
+    bool serve() {
+        bool any = false;
+        MBORecoveryRequest request;
+        while (registry_.takeRecoveryRequest(request)) {
+            any = true;
+            ++requests_;
+            auto it = history_.find(request.instrument_id);
+            if (request.feed_session != session_ || it == history_.end()) {
+                continue;
+            }
+            const std::vector<MBOWire>& history = it->second;
+            const uint32_t last = static_cast<uint32_t>(history.size());
+            const uint32_t first = last > depth_ ? last - static_cast<uint32_t>(depth_) + 1 : 1;
+            const uint32_t to = std::min(request.to_sequence, last);
+            for (uint32_t sequence = request.from_sequence; sequence <= to; ++sequence) {
+                if (sequence < first) {
+                    ++misses_;
+                    continue;
+                }
+                registry_.dispatch(history[sequence - 1]);
+                ++resent_;
+            }
+        }
+        return any;
+    }
+
+    // End of the stream: release held records, then a heartbeat
+    void finish() {
+        faults_.flush([this](const MBOWire& wire) { registry_.dispatch(wire); });
+        for (const auto& entry : history_) {
+            if (!entry.second.empty()) {
+                registry_.dispatch(entry.second.back());
+            }
+        }
+    }
+
+    const FaultInjector<MBOWire>& faults() const { return faults_; }
+    uint64_t requests() const { return requests_; }
+    uint64_t resent() const { return resent_; }
+    uint64_t misses() const { return misses_; }
+
+private:
+    BookRegistry& registry_;
+    FaultInjector<MBOWire> faults_;
+    size_t depth_;
+    uint32_t session_;
+    std::unordered_map<uint32_t, std::vector<MBOWire>> history_;
+    uint64_t requests_;
+    uint64_t resent_;
+    uint64_t misses_;
+};
+
+struct Scenario {
+    const char* name;
+    FaultConfig faults;
+    size_t depth;               // publisher history per instrument
+    double restart_at;          // publisher restarts after this share of the records (0 = never)
+    double join_at;             // subscriber misses this share of the records
+    bool expect_match;          // false: the book must be flagged diverged instead
+};
+
+bool sameLevels(const std::vector<BookLevel>& a, const std::vector<BookLevel>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].price != b[i].price || a[i].qty != b[i].qty || a[i].orders != b[i].orders) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sameBook(const OrderBookManager& a, const OrderBookManager& b) {
+    std::vector<BookLevel> a_bids, a_asks, b_bids, b_asks;
+    a.getDepth(SIZE_MAX, a_bids, a_asks);
+    b.getDepth(SIZE_MAX, b_bids, b_asks);
+    return sameLevels(a_bids, b_bids) && sameLevels(a_asks, b_asks);
+}
+
+bool run(const Scenario& scenario, const std::vector<MBOParsed>& records, const OrderBookManager& reference) {
+    RegistryConfig config;
+    config.snapshot_policy.mode = SnapshotMode::Off;
+    BookRegistry registry(config);
+    if (!registry.init()) {
+        return false;
+    }
+    SimPublisher publisher(registry, scenario.faults, scenario.depth);
+
+    const size_t restart = static_cast<size_t>(scenario.restart_at * records.size());
+    const size_t join = static_cast<size_t>(scenario.join_at * records.size());
+    const auto start = clock_type::now();
+
+    publisher.beginSession();
+    if (restart > 0) {
+        // A first run cut short, then the publisher comes back from the top
+        for (size_t i = 0; i < restart; ++i) {
+            publisher.publish(records[i], i >= join);
+        }
+        publisher.beginSession();
+    }
+    for (size_t i = 0; i < records.size(); ++i) {
+        publisher.publish(records[i], restart > 0 || i >= join);
+    }
+    publisher.finish();
+    const auto fed = clock_type::now();
+
+    // Keep answering until the subscriber stops asking
+    auto last_request = clock_type::now();
+    while (clock_type::now() - last_request < kSettleQuiet && clock_type::now() - fed < kSettleLimit) {
+        if (publisher.serve()) {
+            last_request = clock_type::now();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+    const double settle_ms = std::chrono::duration<double, std::milli>(last_request - fed).count();
+    const double feed_ms = std::chrono::duration<double, std::milli>(fed - start).count();
+    registry.stop();
+
+    const uint32_t instrument_id = records.front().instrument_id;
+    const OrderBookManager* book = registry.find(instrument_id);
+    const bool diverged = registry.diverged(instrument_id);
+    const bool match = book && sameBook(*book, reference);
+    const bool pass = scenario.expect_match ? match && !diverged : diverged;
+
+    std::cout << scenario.name << ": " << (pass ? "PASS" : "FAIL")
+              << " (book " << (match ? "matches" : "differs") << (diverged ? ", flagged diverged" : "") << ")"
+              << std::endl;
+    std::cout << std::fixed << std::setprecision(1)
+              << "  fed in " << feed_ms << " ms, settled " << settle_ms << " ms after; injected "
+              << publisher.faults().dropped() << " drops, " << publisher.faults().reordered() << " reorders; "
+              << publisher.requests() << " requests, " << publisher.resent() << " records resent, "
+              << publisher.misses() << " no longer held" << std::endl;
+    registry.printStats(std::cout);
+    return pass;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "../data_analyze/CLX5_mbo (2).dbn";
+    const uint64_t seed = argc > 2 ? std::stoull(argv[2]) : 1;
+
+    DbnReader reader;
+    if (!reader.open(path)) {
+        return 1;
+    }
+    std::vector<MBOParsed> records;
+    MBOParsed record;
+    for (const DbnMboMsg& msg : reader) {
+        reader.toParsed(msg, record);
+        records.push_back(record);
+    }
+    if (records.empty()) {
+        std::cerr << "No records in " << path << std::endl;
+        return 1;
+    }
+    // The harness compares one book
+    const uint32_t instrument_id = records.front().instrument_id;
+    records.erase(std::remove_if(records.begin(), records.end(),
+                                 [instrument_id](const MBOParsed& r) { return r.instrument_id != instrument_id; }),
+                  records.end());
+
+    OrderBookManager reference(kDefaultMaxOrders, kDefaultMaxPendingCancels, instrument_id);
+    for (const MBOParsed& msg : records) {
+        reference.applyMessage(msg);
+    }
+    std::cout << "Replaying " << records.size() << " records of instrument " << instrument_id << std::endl;
+
+    const size_t full = records.size();
+    FaultConfig none;
+    FaultConfig light;
+    light.drop = 0.001;
+    light.reorder = 0.01;
+    light.seed = seed;
+    FaultConfig heavy;
+    heavy.drop = 0.01;
+    heavy.reorder = 0.05;
+    heavy.reorder_depth = 64;
+    heavy.seed = seed;
+
+    const Scenario scenarios[] = {
+        {"clean", none, full, 0.0, 0.0, true},
+        {"light faults", light, full, 0.0, 0.0, true},
+        {"heavy faults", heavy, full, 0.0, 0.0, true},
+        {"publisher restart", light, full, 0.5, 0.0, true},
+        {"late join", none, full, 0.0, 0.6, true},
+        {"late join, short history", none, full / 4, 0.0, 0.6, false},
+    };
+
+    bool ok = true;
+    for (const Scenario& scenario : scenarios) {
+        ok = run(scenario, records, reference) && ok;
+    }
+    return ok ? 0 : 1;
+}
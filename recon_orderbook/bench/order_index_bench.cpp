@@ -0,0 +1,202 @@
+// Times the book's order index, OrderIndex, against the pooled
+// std::unordered_map it replaced, at 100K and 1M live orders: filling an
+// index sized for them from empty (the map has its buckets reserved,
+// OrderIndex its table allocated), looking them up (present
+// and absent ids, random order), churning at that size (erase one live
+// order, add a new one) and erasing them all.
+//
+//   order_index_bench [ROUNDS]
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ObjectPool.hpp"
+#include "OrderIndex.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+// The previous index: node-based map with nodes from a slab pool
+class PooledMap {
+public:
+    explicit PooledMap(size_t capacity)
+        : pool_(capacity), map_(0, std::hash<uint64_t>(), std::equal_to<uint64_t>(), Allocator(&pool_)) {
+        map_.reserve(capacity);
+    }
+
+    static constexpr const char* name = "unordered_map";
+
+    bool insert(uint64_t order_id, uint32_t handle) { return map_.emplace(order_id, handle).second; }
+
+    uint32_t find(uint64_t order_id) const {
+        auto it = map_.find(order_id);
+        return it != map_.end() ? it->second : UINT32_MAX;
+    }
+
+    bool erase(uint64_t order_id) {
+        auto it = map_.find(order_id);
+        if (it == map_.end()) {
+            return false;
+        }
+        map_.erase(it);
+        return true;
+    }
+
+private:
+    using Value = std::pair<const uint64_t, uint32_t>;
+    using Pool = SlabPool<hashNodeSlotSize<Value>(), alignof(Value)>;
+    using Allocator = PoolAllocator<Value, hashNodeSlotSize<Value>(), alignof(Value)>;
+
+    Pool pool_;
+    std::unordered_map<uint64_t, uint32_t, std::hash<uint64_t>, std::equal_to<uint64_t>, Allocator> map_;
+};
+
+class FlatIndex {
+public:
+    explicit FlatIndex(size_t capacity) : index_(capacity) {}
+
+    static constexpr const char* name = "OrderIndex";
+
+    bool insert(uint64_t order_id, uint32_t handle) { return index_.insert(order_id, handle); }
+
+    uint32_t find(uint64_t order_id) const {
+        const size_t pos = index_.find(order_id);
+        return pos != OrderIndex::npos ? index_.handleAt(pos) : UINT32_MAX;
+    }
+
+    bool erase(uint64_t order_id) {
+        const size_t pos = index_.find(order_id);
+        if (pos == OrderIndex::npos) {
+            return false;
+        }
+        index_.eraseAt(pos);
+        return true;
+    }
+
+private:
+    OrderIndex index_;
+};
+
+struct Timings {
+    double fill = 0.0;
+    double hit = 0.0;
+    double miss = 0.0;
+    double churn = 0.0;
+    double erase = 0.0;
+};
+
+double nsPerOp(clock_type::time_point t0, clock_type::time_point t1, size_t ops) {
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(ops);
+}
+
+// Order ids as a venue hands them out: increasing, with gaps
+std::vector<uint64_t> orderIds(size_t count, std::mt19937_64& rng) {
+    std::vector<uint64_t> ids(count);
+    uint64_t id = 6400000000000ull;
+    for (uint64_t& out : ids) {
+        id += 1 + rng() % 16;
+        out = id;
+    }
+    return ids;
+}
+
+template <typename Index>
+Timings run(size_t live, int rounds) {
+    Timings total;
+    for (int round = 0; round < rounds; ++round) {
+        std::mt19937_64 rng(round + 1);
+        std::vector<uint64_t> ids = orderIds(live * 2, rng);
+        std::vector<uint64_t> absent(ids.begin() + live, ids.end());
+        ids.resize(live);
+
+        Index index(live);
+        uint64_t sink = 0;
+
+        auto t0 = clock_type::now();
+        for (size_t i = 0; i < live; ++i) {
+            sink += index.insert(ids[i], static_cast<uint32_t>(i));
+        }
+        auto t1 = clock_type::now();
+        total.fill += nsPerOp(t0, t1, live);
+
+        std::vector<uint64_t> probe = ids;
+        std::shuffle(probe.begin(), probe.end(), rng);
+        t0 = clock_type::now();
+        for (uint64_t id : probe) {
+            sink += index.find(id);
+        }
+        t1 = clock_type::now();
+        total.hit += nsPerOp(t0, t1, live);
+
+        std::shuffle(absent.begin(), absent.end(), rng);
+        t0 = clock_type::now();
+        for (uint64_t id : absent) {
+            sink += index.find(id);
+        }
+        t1 = clock_type::now();
+        total.miss += nsPerOp(t0, t1, live);
+
+        // Steady state: every erase of a random live order is followed by
+        // an add with a new id
+        std::vector<size_t> victims(live);
+        for (size_t& victim : victims) {
+            victim = rng() % live;
+        }
+        t0 = clock_type::now();
+        for (size_t i = 0; i < live; ++i) {
+            uint64_t& id = ids[victims[i]];
+            sink += index.erase(id);
+            id = absent[i];
+            sink += index.insert(id, static_cast<uint32_t>(i));
+        }
+        t1 = clock_type::now();
+        total.churn += nsPerOp(t0, t1, live);
+
+        std::shuffle(ids.begin(), ids.end(), rng);
+        t0 = clock_type::now();
+        for (uint64_t id : ids) {
+            sink += index.erase(id);
+        }
+        t1 = clock_type::now();
+        total.erase += nsPerOp(t0, t1, live);
+
+        asm volatile("" : : "r"(sink));
+    }
+
+    total.fill /= rounds;
+    total.hit /= rounds;
+    total.miss /= rounds;
+    total.churn /= rounds;
+    total.erase /= rounds;
+    return total;
+}
+
+template <typename Index>
+void print(size_t live, int rounds) {
+    const Timings t = run<Index>(live, rounds);
+    std::cout << "  " << std::left << std::setw(14) << Index::name << std::right << std::fixed
+              << std::setprecision(1)
+              << "fill " << std::setw(6) << t.fill << "   hit " << std::setw(6) << t.hit
+              << "   miss " << std::setw(6) << t.miss << "   erase+insert " << std::setw(6) << t.churn
+              << "   erase " << std::setw(6) << t.erase << "  (ns/op)" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int rounds = argc > 1 ? std::stoi(argv[1]) : 5;
+
+    for (size_t live : {size_t(100000), size_t(1000000)}) {
+        std::cout << live << " live orders, " << rounds << " rounds" << std::endl;
+        print<PooledMap>(live, rounds);
+        print<FlatIndex>(live, rounds);
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Replays a DBN MBO file back to back through one OrderBookManager for a
+// simulated day, each pass shifted in time, sequence and order ids as if
+// the session just went on, and follows the out-of-order cancel buffer.
+// Cancels for orders placed before a pass began never get their add, as
+// with orders that predate a subscriber joining. The unbounded map the
+// manager used to keep them in is replayed alongside for comparison.
+//
+//   pending_cancel_bench [FILE] [HOURS] [CAPACITY] [AGE_MS] [AGE_SEQS]
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DbnReader.hpp"
+#include "ObjectPool.hpp"
+#include "OrderBookManager.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr uint64_t kHourNs = 3600ull * 1000000000ull;
+
+// Order ids of each pass are moved this far past the previous pass's
+constexpr uint64_t kOrderIdShift = 1ull << 40;
+
+// Bytes one entry of the old std::unordered_map<uint64_t, MBOParsed> took:
+// its node plus a bucket pointer at load factor 1
+constexpr size_t kMapEntryBytes = hashNodeSlotSize<std::pair<const uint64_t, MBOParsed>>() + sizeof(void*);
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "../data_analyze/CLX5_mbo (2).dbn";
+    const unsigned hours = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : 24;
+    const size_t capacity = argc > 3 ? std::stoull(argv[3]) : kDefaultMaxPendingCancels;
+    PendingCancelAge age;
+    if (argc > 4) {
+        age.max_age_ns = std::stoull(argv[4]) * 1000000;
+    }
+    if (argc > 5) {
+        age.max_age_sequences = static_cast<uint32_t>(std::stoul(argv[5]));
+    }
+
+    DbnReader reader;
+    if (!reader.open(path)) {
+        return 1;
+    }
+    std::vector<MBOParsed> records;
+    MBOParsed record;
+    for (const DbnMboMsg& msg : reader) {
+        reader.toParsed(msg, record);
+        records.push_back(record);
+    }
+    if (records.empty()) {
+        std::cerr << "No records in " << path << std::endl;
+        return 1;
+    }
+
+    const uint64_t span_ns = records.back().ts_event - records.front().ts_event + 1;
+    const uint32_t span_sequences = records.back().sequence - records.front().sequence + 1;
+    const uint64_t passes = (hours * kHourNs + span_ns - 1) / span_ns;
+    std::cout << "Replaying " << records.size() << " records (" << span_ns / 1000000000 << " s) x " << passes
+              << " passes; buffer of " << capacity << " cancels, age " << age.max_age_ns / 1000000 << " ms / "
+              << age.max_age_sequences << " sequences" << std::endl;
+
+    OrderBookManager manager(kDefaultMaxOrders, capacity, records.front().instrument_id);
+    manager.setPendingCancelAge(age);
+    const PendingCancels& pending = manager.pendingCancels();
+    std::unordered_map<uint64_t, MBOParsed> unbounded;
+
+    std::cout << std::setw(6) << "hour" << std::setw(10) << "held" << std::setw(10) << "matched"
+              << std::setw(10) << "expired" << std::setw(10) << "evicted" << std::setw(14) << "bytes"
+              << std::setw(14) << "map held" << std::setw(14) << "map bytes" << std::endl;
+
+    double apply_secs = 0.0;
+    uint64_t next_hour = 1;
+    for (uint64_t pass = 0; pass < passes; ++pass) {
+        const auto start = clock_type::now();
+        for (MBOParsed msg : records) {
+            msg.ts_event += pass * span_ns;
+            msg.sequence += static_cast<uint32_t>(pass * span_sequences);
+            if (msg.order_id != 0) {
+                msg.order_id += pass * kOrderIdShift;
+            }
+
+            const uint64_t inserted = pending.inserted();
+            manager.applyMessage(msg);
+
+            // What the old map would hold: every cancel that found no
+            // order, until an add for it turned up
+            if (msg.action == 'C' && pending.inserted() != inserted) {
+                unbounded[msg.order_id] = msg;
+            } else if (msg.action == 'A') {
+                unbounded.erase(msg.order_id);
+            }
+        }
+        apply_secs += std::chrono::duration<double>(clock_type::now() - start).count();
+
+        const uint64_t elapsed_ns = (pass + 1) * span_ns;
+        if (elapsed_ns >= next_hour * kHourNs || pass + 1 == passes) {
+            std::cout << std::setw(6) << elapsed_ns / kHourNs << std::setw(10) << pending.size()
+                      << std::setw(10) << pending.matched() << std::setw(10) << pending.expired()
+                      << std::setw(10) << pending.evicted() << std::setw(14) << pending.storageBytes()
+                      << std::setw(14) << unbounded.size() << std::setw(14) << unbounded.size() * kMapEntryBytes
+                      << std::endl;
+            next_hour = elapsed_ns / kHourNs + 1;
+        }
+    }
+
+    std::cout << pending.inserted() << " cancels held in all, " << std::fixed << std::setprecision(1)
+              << apply_secs * 1e9 / (static_cast<double>(passes) * records.size()) << " ns per message" << std::endl;
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Replays a synthetic multi-instrument feed through BookRegistry with 1, 2,
+// 4 and 8 shards and reports end-to-end messages per second. The feed is
+// the DBN file's messages cloned onto N instruments (distinct
+// instrument_id and order ids) and interleaved message by message, so
+// every instrument sees a realistic add/cancel/modify mix.
+//
+//   shard_scaling_bench [FILE] [INSTRUMENTS] [PASSES]
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BookRegistry.hpp"
+#include "DbnReader.hpp"
+#include "MBOWire.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+// Orders each synthetic book is pre-sized for
+constexpr size_t kBenchOrdersPerBook = 4096;
+
+std::vector<MBOWire> buildFeed(const std::vector<MBOParsed>& records, uint32_t instruments) {
+    std::vector<MBOWire> feed;
+    feed.reserve(records.size() * instruments);
+    for (const MBOParsed& record : records) {
+        for (uint32_t i = 0; i < instruments; ++i) {
+            MBOParsed clone = record;
+            clone.instrument_id = record.instrument_id + i;
+            clone.order_id = record.order_id + (static_cast<uint64_t>(i) << 48);
+            feed.push_back(toWire(clone));
+        }
+    }
+    return feed;
+}
+
+void run(const std::vector<MBOWire>& feed, size_t shards, int passes) {
+    double secs = 0.0;
+    uint64_t min_share = UINT64_MAX;
+    uint64_t max_share = 0;
+
+    for (int pass = 0; pass < passes; ++pass) {
+        RegistryConfig config;
+        config.shards = shards;
+        config.max_orders = kBenchOrdersPerBook;
+        config.snapshot_policy.mode = SnapshotMode::Off;
+        BookRegistry registry(config);
+        if (!registry.init()) {
+            return;
+        }
+
+        const auto start = clock_type::now();
+        for (const MBOWire& sample : feed) {
+            registry.dispatchWait(sample);
+        }
+        registry.stop();
+        secs += std::chrono::duration<double>(clock_type::now() - start).count();
+
+        if (pass == 0) {
+            for (size_t i = 0; i < registry.shardCount(); ++i) {
+                const uint64_t share = registry.shard(i).worker().processed();
+                min_share = std::min(min_share, share);
+                max_share = std::max(max_share, share);
+            }
+        }
+    }
+
+    std::cout << std::setw(2) << shards << " shards " << std::fixed << std::setprecision(2)
+              << std::setw(8) << feed.size() * passes / secs / 1e6 << " M msg/s"
+              << "   messages per shard " << min_share << ".." << max_share << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "../data_analyze/CLX5_mbo (2).dbn";
+    const uint32_t instruments = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 64;
+    const int passes = argc > 3 ? std::stoi(argv[3]) : 3;
+
+    DbnReader reader;
+    if (!reader.open(path)) {
+        return 1;
+    }
+
+    std::vector<MBOParsed> records;
+    MBOParsed record;
+    for (const DbnMboMsg& msg : reader) {
+        reader.toParsed(msg, record);
+        records.push_back(record);
+    }
+    const std::vector<MBOWire> feed = buildFeed(records, instruments);
+
+    std::cout << "Replaying " << feed.size() << " messages over " << instruments << " instruments x "
+              << passes << " passes (" << std::thread::hardware_concurrency() << " cores)" << std::endl;
+
+    for (size_t shards : {1, 2, 4, 8}) {
+        run(feed, shards, passes);
+    }
+    return 0;
+}
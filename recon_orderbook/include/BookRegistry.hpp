@@ -0,0 +1,241 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BookWorker.hpp"
+#include "FeedSequencer.hpp"
+#include "InstrumentTable.hpp"
+#include "Journal.hpp"
+#include "MBORecovery.hpp"
+#include "MBOWire.hpp"
+#include "OrderBookManager.hpp"
+#include "Snapshot.hpp"
+#include "SnapshotWriter.hpp"
+#include "SPSCRing.hpp"
+#include "StatsSegment.hpp"
+#include "Timestamp.hpp"
+
+// Recovery requests a shard can have waiting to be sent
+constexpr size_t kRecoveryQueueSize = 1024;
+
+struct RegistryConfig {
+    size_t shards = 1;
+
+    // Ring and placement of each shard's book thread; shard k is pinned
+    // to worker.cpu + k when worker.cpu >= 0
+    WorkerConfig worker;
+
+    // Orders each book's pools start with (they grow past it if needed),
+    // and the out-of-order cancels each book holds at most, and how long
+    size_t max_orders = kDefaultMaxOrders;
+    size_t max_pending_cancels = kDefaultMaxPendingCancels;
+    PendingCancelAge pending_cancel_age;
+
+    // Tick size of each instrument's book, and how its sides store levels
+    InstrumentTable instruments;
+    BookLayout layout = BookLayout::Sorted;
+
+    // Reduce resting orders on 'F' fills. Off for CME (MDP3) data, which
+    // follows every fill with an explicit C or M for the resting order;
+    // applying both would take the execution out of the book twice. Turn
+    // it on for venues whose fills are the only record of an execution.
+    bool apply_fills = false;
+
+    // Reordering and gap recovery of each instrument's feed
+    SequencerConfig sequencer;
+
+    // Snapshot and journal outputs. Every shard gets its own sinks and
+    // journal; with more than one shard, file paths get a ".shardK"
+    // suffix before the extension.
+    SnapshotPolicy snapshot_policy;
+    std::vector<std::string> snapshot_sinks;
+    std::string journal_path;
+    uint64_t journal_snapshot_every = kDefaultJournalSnapshotEvery;
+};
+
+// The books of every instrument that hashes to one shard, with the
+// shard's snapshot writer and journal. After init() only the shard's book
+// thread touches them, so nothing here takes a lock.
+//
+// Samples stamped with a feed session and sequence go through their
+// instrument's FeedSequencer first: late ones wait for the gap before
+// them, a new session resets the book, and gaps that don't fill by
+// themselves become recovery requests queued for the dispatcher thread.
+//
+// Records the publisher stamped with ts_send are timed from that stamp to
+// decoded (parsed) and to applied to the book (tick-to-book). Those
+// latencies and the shard's counters live in a ShardStats block, its own
+// or one in the process's stats segment.
+class BookShard {
+public:
+    BookShard(size_t index, const RegistryConfig& config);
+
+    // Open the shard's outputs; false (with the reason reported) on failure
+    bool init();
+
+    // Keep counters in stats (a stats segment's block) instead of the
+    // shard's own; before start()
+    void setStats(ShardStats* stats) { stats_ = stats; }
+
+    void start();
+
+    // Apply everything still queued and close the outputs
+    void stop();
+
+    // Book thread: sequence one sample and apply what is in order to its
+    // instrument's book
+    void process(const MBOWire& sample);
+
+    // Book thread: run the gap timers of instruments waiting on a gap
+    // (cheap when there are none)
+    void poll() {
+        if (!gapped_.empty()) {
+            pollGaps();
+        }
+    }
+
+    // Book thread: bring the stats gauges up to date, at most every
+    // kStatsRefreshNs
+    void refreshStats() {
+        const uint64_t now_ns = monotonicNowNs();
+        if (now_ns >= next_stats_ns_) {
+            next_stats_ns_ = now_ns + kStatsRefreshNs;
+            publishGauges();
+        }
+    }
+
+    // Dispatcher: next recovery request to send, if any
+    bool takeRecoveryRequest(MBORecoveryRequest& request) { return recovery_.tryPop(request); }
+
+    BookWorker& worker() { return worker_; }
+    const BookWorker& worker() const { return worker_; }
+
+    // Only safe once the shard is stopped
+    const OrderBookManager* find(uint32_t instrument_id) const;
+    bool diverged(uint32_t instrument_id) const;
+    size_t bookCount() const { return books_.size(); }
+
+    // Readable from any thread
+    const ShardStats& stats() const { return *stats_; }
+
+    // From the stats block only, so any thread can call it while the book
+    // thread runs (figures up to kStatsRefreshNs old; final after stop())
+    void printStats(std::ostream& out) const;
+
+private:
+    struct Instrument {
+        Instrument(const RegistryConfig& config, uint32_t instrument_id)
+            : book(config.max_orders, config.max_pending_cancels, instrument_id, config.layout),
+              feed(config.sequencer), gapped(false) {
+        }
+
+        OrderBookManager book;
+        FeedSequencer feed;
+        bool gapped;            // listed in gapped_
+    };
+
+    // Book and sequencer for sample's instrument, created on first sight
+    Instrument& instrumentFor(const MBOWire& sample);
+
+    // Apply sample, then whatever it lets through
+    void apply(Instrument& instrument, const MBOWire& sample);
+
+    // Decode one in-order record and apply it to book, timing it if stamped
+    void applyRecord(OrderBookManager& book, const MBOWire& sample);
+
+    // Run instrument's gap timers at now_ns
+    void pollGap(Instrument& instrument, uint64_t now_ns);
+    void pollGaps();
+
+    // Walk the books for the stats gauges
+    void publishGauges();
+
+    size_t index_;
+    const RegistryConfig& config_;
+
+    std::unordered_map<uint32_t, std::unique_ptr<Instrument>> books_;
+
+    // Feeds send runs of one instrument; skip the map lookup for those
+    uint32_t last_instrument_;
+    Instrument* last_book_;
+
+    // Instruments with an open gap, and requests for the dispatcher
+    std::vector<Instrument*> gapped_;
+    SPSCRing<MBORecoveryRequest> recovery_;
+    uint64_t recovery_dropped_;
+
+    SnapshotWriter snapshot_writer_;
+    std::unique_ptr<JournalWriter> journal_;
+
+    // Written by the book thread
+    ShardStats local_stats_;
+    ShardStats* stats_;
+    uint64_t next_stats_ns_;
+
+    // Declared last so the book thread is joined before anything it uses
+    // is destroyed
+    BookWorker worker_;
+};
+
+// Keys books by instrument_id and spreads instruments over N shards by a
+// stable hash. One dispatcher thread routes each sample to its shard over
+// that shard's SPSC ring; each shard's book thread owns its books.
+class BookRegistry {
+public:
+    explicit BookRegistry(const RegistryConfig& config);
+    ~BookRegistry();
+
+    // Keep each shard's counters in segment's block for it; before init()
+    void setStats(StatsSegment& segment);
+
+    // Open outputs and start the shard threads
+    bool init();
+
+    // Drain every shard and close the outputs
+    void stop();
+
+    // Dispatcher: queue sample on its instrument's shard. False if that
+    // shard's ring was full and the sample was dropped.
+    bool dispatch(const MBOWire& sample) {
+        return shards_[shardOf(sample.instrument_id)]->worker().push(sample);
+    }
+
+    // Dispatcher: wait for room instead of dropping (replay, benchmarks)
+    void dispatchWait(const MBOWire& sample) {
+        shards_[shardOf(sample.instrument_id)]->worker().pushWait(sample);
+    }
+
+    // Stable across runs and processes, so an instrument always lands on
+    // the same shard (and in the same journal file)
+    size_t shardOf(uint32_t instrument_id) const {
+        return static_cast<size_t>(((instrument_id * 0x9E3779B97F4A7C15ULL) >> 32) % shards_.size());
+    }
+
+    size_t shardCount() const { return shards_.size(); }
+    const BookShard& shard(size_t index) const { return *shards_[index]; }
+
+    // Only safe once the registry is stopped
+    const OrderBookManager* find(uint32_t instrument_id) const {
+        return shards_[shardOf(instrument_id)]->find(instrument_id);
+    }
+
+    // Records of the instrument were lost for good this feed session.
+    // Only safe once the registry is stopped.
+    bool diverged(uint32_t instrument_id) const {
+        return shards_[shardOf(instrument_id)]->diverged(instrument_id);
+    }
+
+    // Dispatcher: next recovery request any shard wants sent
+    bool takeRecoveryRequest(MBORecoveryRequest& request);
+
+    void printStats(std::ostream& out) const;
+
+private:
+    RegistryConfig config_;
+    std::vector<std::unique_ptr<BookShard>> shards_;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <thread>
+#include "MBOWire.hpp"
+#include "SPSCRing.hpp"
+
+class BookShard;
+
+// Raw samples the ingest ring holds (72 bytes each)
+constexpr size_t kDefaultIngestRingSize = 65536;
+
+struct WorkerConfig {
+    int cpu = -1;                               // core to pin the book thread to, -1 = no pinning
+    size_t ring_size = kDefaultIngestRingSize;
+    bool busy_poll = false;                     // spin forever instead of backing off when idle
+};
+
+// Owns a shard's book thread. The dispatcher (the DDS listener) only
+// copies raw wire samples into a preallocated SPSC ring; the book thread
+// hands them to its shard to sequence, decode and apply, so FastDDS jitter
+// never lands on the books and vice versa.
+//
+// When idle the book thread spins, then yields, then sleeps briefly
+// (unless busy_poll is set), running the shard's gap timers between
+// polls. Samples arriving at a full ring are dropped and counted; the
+// shard's sequencers see the hole and recover it.
+class BookWorker {
+public:
+    BookWorker(BookShard& shard, const WorkerConfig& config);
+    ~BookWorker();
+
+    void start();
+
+    // Apply everything still queued, then join the book thread
+    void stop();
+
+    // Producer side (one thread): false if the ring was full
+    bool push(const MBOWire& sample);
+
+    // Producer side: wait for room instead of dropping (replay, benchmarks)
+    void pushWait(const MBOWire& sample);
+
+    // Stats, readable from any thread
+    size_t occupancy() const { return ring_.size(); }
+    size_t capacity() const { return ring_.capacity(); }
+    size_t highWater() const { return high_water_.load(std::memory_order_relaxed); }
+    uint64_t received() const { return received_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    uint64_t processed() const { return processed_.load(std::memory_order_relaxed); }
+
+    void printStats(std::ostream& out) const;
+
+private:
+    void run();
+
+    // Pin the calling thread to config_.cpu
+    void pin();
+
+    BookShard& shard_;
+    WorkerConfig config_;
+    SPSCRing<MBOWire> ring_;
+
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    // Written by the producer
+    std::atomic<uint64_t> received_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<size_t> high_water_;
+
+    // Written by the book thread
+    std::atomic<uint64_t> processed_;
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MBORecovery.hpp"
+#include "MBOWire.hpp"
+
+// Records of one instrument held ahead of a gap
+constexpr size_t kDefaultReorderCapacity = 1024;
+
+struct SequencerConfig {
+    size_t reorder_capacity = kDefaultReorderCapacity;
+
+    // How long a gap may stay open before the missing records are asked
+    // for (a reordered record normally turns up well within it)
+    std::chrono::microseconds gap_timeout{1000};
+
+    // How long to wait for a resend before asking again, and how many
+    // times to ask before skipping the gap and flagging the book diverged
+    std::chrono::microseconds recovery_timeout{50000};
+    unsigned max_recovery_attempts = 3;
+};
+
+// Puts one instrument's feed back in publisher order. Records are
+// numbered from 1 in each publisher session; a record past a gap waits in
+// a bounded window until the gap fills, and a gap that doesn't fill by
+// itself is recovered by asking the publisher to resend it. Only the
+// instrument's book thread touches it, and time only advances through
+// poll(), so offer() never reads the clock.
+class FeedSequencer {
+public:
+    enum class Verdict {
+        Apply,          // next in sequence: apply it, then drain()
+        NewSession,     // the publisher restarted: reset the book and offer the sample again
+        Held,           // past a gap, kept until the gap fills
+        Dropped         // already applied, or too far ahead to keep (it is recovered later)
+    };
+
+    explicit FeedSequencer(const SequencerConfig& config = SequencerConfig());
+
+    Verdict offer(const MBOWire& sample);
+
+    // Next kept record that is now in sequence. Call until false after
+    // every Apply and every poll().
+    bool drain(MBOWire& sample);
+
+    // A gap is open; poll() must be called until it closes
+    bool gapOpen() const { return gap_open_; }
+
+    // Run the gap timers. True with request filled when missing records
+    // should be asked for; call again until false, as each run of missing
+    // records gets its own request. Once the attempts run out the gap is
+    // skipped and drain() resumes past it.
+    bool poll(uint64_t now_ns, MBORecoveryRequest& request);
+
+    uint32_t session() const { return session_; }
+    uint32_t expected() const { return expected_; }
+
+    // Records were lost for good this session
+    bool diverged() const { return diverged_; }
+
+    uint64_t sessions() const { return sessions_; }
+    uint64_t gaps() const { return gaps_; }
+    uint64_t reordered() const { return reordered_; }       // gaps that filled by themselves
+    uint64_t recovered() const { return recovered_; }       // gaps filled by a resend
+    uint64_t unrecovered() const { return unrecovered_; }   // gaps skipped
+    uint64_t skippedRecords() const { return skipped_records_; }
+    uint64_t requests() const { return requests_; }
+    uint64_t duplicates() const { return duplicates_; }
+    uint64_t overflows() const { return overflows_; }
+
+private:
+    // Give up on the records at expected_: carry on from the next kept
+    // one (or past everything seen)
+    void skipGap();
+
+    // sequence is waiting in the window
+    bool kept(uint32_t sequence) const;
+
+    // Last sequence seen that the window has room for
+    uint32_t windowEnd() const;
+
+    // Ask for every missing run from from to highest_, starting with the
+    // next nextRequest()
+    void startRequests(uint32_t from, uint64_t now_ns);
+    bool nextRequest(MBORecoveryRequest& request);
+
+    SequencerConfig config_;
+
+    // Kept records by feed_sequence & mask_; a slot is live when its
+    // session and sequence match what is looked for
+    std::vector<MBOWire> window_;
+    uint32_t mask_;
+
+    uint32_t instrument_id_;
+    uint32_t session_;          // 0 until the first sequenced record
+    uint32_t expected_;         // next sequence to apply
+    uint32_t highest_;          // highest sequence seen this session
+    uint32_t lowest_overflow_;  // lowest sequence dropped for want of room
+
+    bool gap_open_;
+    bool requested_;
+    bool skipped_;              // the open gap is what is left after a skip
+    bool issuing_;              // nextRequest() has runs left to ask for
+    uint64_t gap_started_ns_;   // 0 until poll() first sees the gap
+    uint64_t request_sent_ns_;
+    uint64_t tail_started_ns_;  // first poll to see records past requested_to_
+    unsigned attempts_;
+    uint32_t requested_to_;     // highest sequence the requests covered
+    uint32_t progress_mark_;    // expected_ when last checked for progress
+    uint32_t cursor_;           // where nextRequest() looks next
+    bool diverged_;
+
+    uint64_t sessions_;
+    uint64_t gaps_;
+    uint64_t reordered_;
+    uint64_t recovered_;
+    uint64_t unrecovered_;
+    uint64_t skipped_records_;
+    uint64_t requests_;
+    uint64_t duplicates_;
+    uint64_t overflows_;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MBOParsed.hpp"
+
+// Price grid of one instrument. Books keep prices as integer ticks;
+// fixed-point (kPriceScale) prices are converted on the way in and out.
+struct TickSize {
+    int64_t tick = 1;           // kPriceScale units per tick (1 = DBN's native grid)
+    unsigned decimals = 2;      // fractional digits always printed
+
+    // Nearest tick to a fixed-point price. off_grid is set when the price
+    // is not a whole number of ticks.
+    int64_t toTicks(int64_t price, bool& off_grid) const {
+        if (tick == 1) {
+            off_grid = false;
+            return price;
+        }
+        int64_t ticks = price / tick;
+        int64_t rest = price % tick;
+        off_grid = rest != 0;
+        if (rest < 0) {
+            rest += tick;
+            --ticks;
+        }
+        return rest * 2 >= tick ? ticks + 1 : ticks;
+    }
+
+    int64_t toPrice(int64_t ticks) const { return ticks * tick; }
+};
+
+// Tick sizes by instrument, loaded from a small definitions file:
+//
+//   # instrument_id, symbol or product root ending in '*', tick size
+//   CL*,0.01
+//   432669,0.01
+//
+// Lookups prefer the instrument_id, then the exact symbol, then the
+// longest matching product root. Unknown instruments get DBN's native
+// 1e-9 grid, so their prices stay exact.
+class InstrumentTable {
+public:
+    // Add the file's definitions; false (with the line reported) if it
+    // can't be read or a line is malformed
+    bool load(const std::string& path);
+
+    // Add one definition from its key (as in the file) and tick size in
+    // kPriceScale units. False if the key or tick is invalid.
+    bool add(const std::string& key, int64_t tick);
+
+    TickSize lookup(uint32_t instrument_id, const char* symbol) const;
+
+    size_t size() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        uint32_t instrument_id;     // 0 when keyed by symbol
+        std::string symbol;         // symbol or product root
+        bool root;
+        TickSize tick;
+    };
+
+    std::vector<Entry> entries_;
+};
+
+// Parse a decimal tick size ("0.01", "0.25", "1") into kPriceScale units.
+// Returns 0 if malformed, zero, or finer than 1e-9.
+int64_t parseTickSize(const char* text, size_t len);
+
+// Write a fixed-point price exactly: at least decimals fractional digits,
+// more only when the price needs them. Returns the characters written.
+size_t formatPrice(int64_t price, unsigned decimals, char* out, size_t len);
+std::string formatPrice(int64_t price, unsigned decimals);
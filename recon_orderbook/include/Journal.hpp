@@ -0,0 +1,236 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MBOParsed.hpp"
+#include "PendingCancels.hpp"
+#include "SPSCRing.hpp"
+
+// Binary journal of the reconstructed books: periodic full L3 snapshots
+// of each instrument interleaved with every applied message, written
+// append-only. A closed journal ends with an index of its snapshots so a
+// reader can jump to the nearest one and replay only the deltas after it.
+// Sequence numbers and times restart with every feed session (a replayed
+// file, a restarted publisher), so every record carries the session it
+// was applied in and lookups stay within one session.
+//
+// Layout (all little endian, every record 8-byte aligned):
+//   JournalFileHeader
+//   { JournalRecordHeader, payload }*
+//   JournalIndexEntry[index_count]
+//   JournalFooter
+//
+// Delta payload:    JournalDeltaHeader, MBOParsed
+// Snapshot payload: JournalSnapshotHeader,
+//                   JournalOrder[bid_orders + ask_orders] (bids then asks,
+//                   best level first, queue order within a level),
+//                   PendingCancel[pending_cancels]
+
+constexpr char kJournalMagic[8] = {'M', 'B', 'O', 'J', 'R', 'N', 'L', '\0'};
+constexpr char kJournalIndexMagic[8] = {'M', 'B', 'O', 'J', 'I', 'D', 'X', '\0'};
+constexpr uint32_t kJournalVersion = 4;
+
+// Messages of one instrument between its journal snapshots
+constexpr uint64_t kDefaultJournalSnapshotEvery = 10000;
+
+// Size of each journal write buffer handed to the I/O thread
+constexpr size_t kJournalBufferSize = 4 << 20;
+constexpr size_t kJournalBuffers = 4;
+
+enum class JournalRecordType : uint32_t {
+    Delta = 1,
+    Snapshot = 2
+};
+
+struct JournalFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+};
+
+struct JournalRecordHeader {
+    uint32_t type;
+    uint32_t length;    // payload bytes
+};
+
+struct JournalDeltaHeader {
+    uint32_t feed_session;      // 0 for an unsequenced feed
+    uint32_t reserved;
+};
+
+struct JournalSnapshotHeader {
+    uint64_t ts_event;          // of the last message applied
+    int64_t last_trade_price;
+    uint64_t traded_volume;
+    uint32_t sequence;          // of the last message applied
+    uint32_t last_trade_qty;
+    uint32_t bid_orders;
+    uint32_t ask_orders;
+    uint32_t pending_cancels;
+    uint32_t instrument_id;
+    uint32_t feed_session;
+    char symbol[kSymbolLen];
+    char reserved[3];
+};
+
+struct JournalOrder {
+    uint64_t order_id;
+    uint64_t timestamp;
+    int64_t price;
+    uint32_t qty;
+    uint32_t reserved;
+};
+
+struct JournalIndexEntry {
+    uint64_t offset;    // of the snapshot's JournalRecordHeader
+    uint64_t ts_event;
+    uint32_t sequence;
+    uint32_t instrument_id;
+    uint32_t feed_session;
+    uint32_t reserved;
+};
+
+struct JournalFooter {
+    uint64_t index_offset;
+    uint64_t index_count;
+    uint64_t delta_count;
+    uint32_t first_sequence;
+    uint32_t last_sequence;
+    uint32_t last_session;      // of the last message
+    uint32_t reserved;
+    char magic[8];
+};
+
+static_assert(sizeof(JournalFileHeader) == 16, "journal layout");
+static_assert(sizeof(JournalRecordHeader) == 8, "journal layout");
+static_assert(sizeof(JournalDeltaHeader) == 8, "journal layout");
+static_assert(sizeof(JournalSnapshotHeader) == 64, "journal layout");
+static_assert(sizeof(JournalOrder) == 32, "journal layout");
+static_assert(sizeof(PendingCancel) == 24, "journal layout");
+static_assert(sizeof(JournalIndexEntry) == 32, "journal layout");
+static_assert(sizeof(JournalFooter) == 48, "journal layout");
+
+// Appends journal records from the ingest thread. Records are copied into
+// large buffers; full buffers go to an I/O thread over an SPSC ring, so
+// the caller only blocks if the disk falls a whole set of buffers behind.
+class JournalWriter {
+public:
+    JournalWriter();
+    ~JournalWriter();
+
+    bool open(const std::string& path);
+
+    // Write out buffered records, the index and the footer
+    void close();
+
+    void appendDelta(const MBOParsed& msg, uint32_t feed_session);
+
+    // A snapshot record is its header followed by exactly the announced
+    // number of orders and pending cancels
+    void beginSnapshot(const JournalSnapshotHeader& header);
+    void appendOrder(const JournalOrder& order) { append(&order, sizeof(order)); }
+    void appendPendingCancel(const PendingCancel& cancel) { append(&cancel, sizeof(cancel)); }
+
+    uint64_t bytesWritten() const { return offset_; }
+    uint64_t snapshots() const { return index_.size(); }
+
+    // Times the ingest thread had to wait for a free buffer
+    uint64_t stalls() const { return stalls_; }
+
+private:
+    void append(const void* data, size_t len);
+
+    // Queue the current buffer for the I/O thread and take a free one
+    void submit();
+
+    void run();
+
+    int fd_;
+    uint64_t offset_;
+    uint64_t stalls_;
+    std::vector<JournalIndexEntry> index_;
+    uint64_t delta_count_;
+    uint32_t first_sequence_;
+    uint32_t last_sequence_;
+    uint32_t last_session_;
+
+    struct Buffer {
+        std::vector<char> data;
+        size_t used;
+    };
+    std::vector<Buffer> buffers_;
+    uint32_t current_;
+    SPSCRing<uint32_t> free_;     // I/O thread -> ingest
+    SPSCRing<uint32_t> full_;     // ingest -> I/O thread
+
+    std::thread thread_;
+    std::atomic<bool> running_;
+    std::atomic<bool> failed_;
+};
+
+class OrderBookManager;
+
+// Memory-maps a journal and rebuilds the book at any sequence number or
+// event time within a feed session. A journal without a valid footer (the writer died) is
+// scanned once to rebuild the index.
+class JournalReader {
+public:
+    JournalReader();
+    ~JournalReader();
+
+    JournalReader(const JournalReader&) = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const std::vector<JournalIndexEntry>& index() const { return index_; }
+    uint64_t deltaCount() const { return delta_count_; }
+    uint32_t firstSequence() const { return first_sequence_; }
+    uint32_t lastSequence() const { return last_sequence_; }
+    uint32_t lastSession() const { return last_session_; }
+
+    // Instrument of the first message (the only one in a single-book journal)
+    uint32_t firstInstrument() const { return first_instrument_; }
+
+    // Rebuild instrument_id's book as it was after its last message of
+    // feed_session with sequence <= target (or ts_event <= target).
+    // Returns the number of deltas replayed after the starting snapshot.
+    size_t rebuildAtSequence(uint32_t instrument_id, uint32_t feed_session, uint32_t target,
+                             OrderBookManager& manager) const;
+    size_t rebuildAtTime(uint32_t instrument_id, uint32_t feed_session, uint64_t target,
+                         OrderBookManager& manager) const;
+
+private:
+    // Walk every record from the start to build the index and stats
+    void scan();
+
+    void readFirstInstrument();
+
+    size_t rebuild(uint32_t instrument_id, uint32_t feed_session, uint64_t target, bool by_time,
+                   OrderBookManager& manager) const;
+
+    static void readDelta(const JournalRecordHeader* record, JournalDeltaHeader& delta, MBOParsed& msg);
+
+    // Load the snapshot record at offset into manager
+    void loadSnapshot(uint64_t offset, OrderBookManager& manager) const;
+
+    const JournalRecordHeader* recordAt(uint64_t offset) const {
+        return reinterpret_cast<const JournalRecordHeader*>(data_ + offset);
+    }
+
+    int fd_;
+    const char* data_;
+    size_t size_;
+    uint64_t records_end_;      // start of the index, or file end if unindexed
+    std::vector<JournalIndexEntry> index_;
+    uint64_t delta_count_;
+    uint32_t first_sequence_;
+    uint32_t last_sequence_;
+    uint32_t last_session_;
+    uint32_t first_instrument_;
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "ObjectPool.hpp"
+#include "Order.hpp"
+#include "OrderIndex.hpp"
+
+// Live orders the book is sized for at startup (pool high-water mark)
+constexpr size_t kDefaultMaxOrders = 65536;
+
+// Price levels per side the book is sized for at startup
+constexpr size_t kDefaultMaxLevels = 4096;
+
+// One price level: FIFO of resting orders plus running totals. Book
+// prices are integer ticks; the owner maps them to fixed-point.
+struct PriceLevel {
+    int64_t price;              // ticks
+    uint64_t total_qty;
+    uint32_t order_count;
+    Order* head;
+    Order* tail;
+};
+
+// Aggregated view of one price level (orders == 0 means no level)
+struct BookLevel {
+    int64_t price;
+    uint64_t qty;
+    uint32_t orders;
+};
+
+// Best bid and ask with their aggregates
+struct TopOfBook {
+    BookLevel bid;
+    BookLevel ask;
+};
+
+// How a BookSide stores its levels
+enum class BookLayout {
+    Sorted,     // sorted array, best at the back
+    Ladder      // tick-indexed window around the touch, sorted array beyond it
+};
+
+// Ticks a Ladder window spans (a two-level bitmap covers up to 64 * 64)
+constexpr size_t kLadderTicks = 4096;
+
+// One side of the book. Level objects never move, so orders can point at
+// theirs.
+//
+// Sorted: levels live in a sorted array with the best price at the back,
+// so inserts and removals near the touch shift only a few entries.
+//
+// Ladder: levels within kLadderTicks / 2 of the best price sit in a
+// tick-indexed window of slots, with a bitmap of occupied slots (and a
+// summary word of occupied bitmap words). The best slot is cached; when
+// its level goes, the next best is two bit scans away. Levels further behind fall back to the sorted array. The
+// window is re-centred lazily: when a price improves past it, when
+// activity drifts away from its centre, or when it empties. Prices must
+// be ticks; on a 1e-9 grid nearly everything would land in the array.
+class BookSide {
+public:
+    BookSide(bool is_buy, size_t max_levels, BookLayout layout = BookLayout::Sorted);
+
+    // Level at price, created empty if missing
+    PriceLevel* findOrCreate(int64_t price);
+
+    // Drop an empty level
+    void removeLevel(PriceLevel* level);
+
+    size_t levelCount() const { return window_levels_ + levels_.size(); }
+    BookLayout layout() const { return ladder_ ? BookLayout::Ladder : BookLayout::Sorted; }
+
+    const PriceLevel* best() const {
+        if (window_levels_ > 0) {
+            return slots_[best_slot_];
+        }
+        return levels_.empty() ? nullptr : levels_.back().level;
+    }
+
+    // Aggregates of the best level, or an empty level
+    BookLevel bestAggregate() const {
+        const PriceLevel* l = best();
+        return l ? BookLevel{l->price, l->total_qty, l->order_count} : BookLevel{0, 0, 0};
+    }
+
+    // Call fn(const PriceLevel&) on up to max_levels levels, best first
+    template <typename Fn>
+    void forEachLevel(Fn&& fn, size_t max_levels = SIZE_MAX) const;
+
+    void clear();
+
+private:
+    struct Entry {
+        int64_t price;
+        PriceLevel* level;
+    };
+
+    // Position of the first entry that is not worse than price
+    std::vector<Entry>::iterator lowerBound(int64_t price);
+
+    PriceLevel* sortedFindOrCreate(int64_t price);
+    void sortedRemove(PriceLevel* level);
+
+    // Window positions are ranks: the price for bids, its negation for
+    // asks, so the best level is always the highest occupied slot
+    int64_t rankOf(int64_t price) const { return is_buy_ ? price : -price; }
+
+    bool occupied(size_t slot) const { return (bits_[slot / 64] >> (slot % 64)) & 1; }
+
+    // Slot of the best window level from the bitmap (window_levels_ > 0)
+    size_t scanBest() const {
+        const size_t word = 63 - static_cast<size_t>(__builtin_clzll(summary_));
+        return word * 64 + 63 - static_cast<size_t>(__builtin_clzll(bits_[word]));
+    }
+
+    PriceLevel* ladderFindOrCreate(int64_t price);
+    void ladderRemove(PriceLevel* level);
+    void setSlot(size_t slot, PriceLevel* level);
+    void clearSlot(size_t slot);
+
+    // Move the window so rank (at or above every level's rank) sits in
+    // its middle, trading levels with the sorted array
+    void recentre(int64_t rank);
+
+    bool is_buy_;
+    bool ladder_;
+    std::vector<Entry> levels_;     // worst -> best; in Ladder only levels behind the window
+    ObjectPool<PriceLevel> level_pool_;
+
+    // Ladder window: slot i holds rank base_ + i
+    int64_t base_;
+    size_t window_levels_;
+    size_t best_slot_;              // valid while window_levels_ > 0
+    std::vector<PriceLevel*> slots_;  // meaningful only where the bit is set
+    uint64_t bits_[kLadderTicks / 64];
+    uint64_t summary_;              // bit w set when bits_[w] != 0
+};
+
+template <typename Fn>
+void BookSide::forEachLevel(Fn&& fn, size_t max_levels) const {
+    size_t visited = 0;
+    // Window levels are all better than the sorted array's
+    for (uint64_t summary = summary_; summary != 0 && visited < max_levels;) {
+        const size_t word = 63 - static_cast<size_t>(__builtin_clzll(summary));
+        summary &= ~(uint64_t(1) << word);
+        for (uint64_t bits = bits_[word]; bits != 0 && visited < max_levels; ++visited) {
+            const size_t bit = 63 - static_cast<size_t>(__builtin_clzll(bits));
+            bits &= ~(uint64_t(1) << bit);
+            fn(*slots_[word * 64 + bit]);
+        }
+    }
+    for (auto it = levels_.rbegin(); it != levels_.rend() && visited < max_levels; ++it, ++visited) {
+        fn(*it->level);
+    }
+}
+
+// Purpose-built L3 (market-by-order) mirror book. No matching: every
+// operation applies exactly what the feed says happened to one order.
+class MBOBook {
+public:
+    explicit MBOBook(size_t max_orders = kDefaultMaxOrders, BookLayout layout = BookLayout::Sorted);
+    ~MBOBook();
+
+    MBOBook(const MBOBook&) = delete;
+    MBOBook& operator=(const MBOBook&) = delete;
+
+    // Returns false if order_id is already live
+    bool add(uint64_t order_id, bool is_buy, int64_t price, uint32_t qty, uint64_t timestamp);
+
+    // Cancel qty (0 or >= remaining cancels the whole order).
+    // Returns false if order_id is unknown.
+    bool cancel(uint64_t order_id, uint32_t qty);
+
+    // Set the order's price and qty. A size-down at the same price keeps
+    // the order's place in its queue; a new price or a size-up moves it
+    // to the back of the queue. Returns false if order_id is unknown.
+    bool modify(uint64_t order_id, int64_t price, uint32_t qty, uint64_t timestamp);
+
+    // Execute qty against a resting order, removing it when fully filled.
+    // Returns false if order_id is unknown.
+    bool fill(uint64_t order_id, uint32_t qty);
+
+    const Order* find(uint64_t order_id) const;
+
+    // O(1): best level of each side
+    TopOfBook topOfBook() const { return TopOfBook{bids_.bestAggregate(), asks_.bestAggregate()}; }
+
+    // Up to n levels per side, best first. Output vectors are reused.
+    void depth(size_t n, std::vector<BookLevel>& bids, std::vector<BookLevel>& asks) const;
+
+    // Remove every order and level in constant time: orders and levels
+    // go back to their pools in one step and the index starts a new epoch
+    void clear();
+
+    size_t orderCount() const { return orders_.size(); }
+    const ObjectPool<Order>& orderPool() const { return order_pool_; }
+    const BookSide& bids() const { return bids_; }
+    const BookSide& asks() const { return asks_; }
+
+private:
+    BookSide& sideOf(bool is_buy) { return is_buy ? bids_ : asks_; }
+
+    // Append order at the tail of the level for its price
+    void link(Order* order);
+
+    // Take order out of its level, dropping the level if it empties
+    void unlink(Order* order);
+
+    // Put order behind every other order of its level
+    void moveToBack(Order* order);
+
+    BookSide bids_;
+    BookSide asks_;
+
+    // Order nodes come from a pool and the index is a flat table, both
+    // sized at startup
+    ObjectPool<Order> order_pool_;
+
+    // order_id -> handle of the order node in order_pool_
+    OrderIndex orders_;
+};
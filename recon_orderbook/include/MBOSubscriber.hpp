@@ -1,36 +1,88 @@
 #pragma once
 
 #include <fastdds/dds/domain/DomainParticipant.hpp>
+#include <fastdds/dds/publisher/Publisher.hpp>
+#include <fastdds/dds/publisher/DataWriter.hpp>
 #include <fastdds/dds/subscriber/Subscriber.hpp>
 #include <fastdds/dds/topic/Topic.hpp>
+#include <fastdds/dds/topic/ContentFilteredTopic.hpp>
 #include <fastdds/dds/subscriber/DataReader.hpp>
 #include <fastdds/dds/subscriber/DataReaderListener.hpp>
 #include <fastdds/dds/core/status/SubscriptionMatchedStatus.hpp>
 #include <memory>
+#include <string>
+#include <vector>
+#include "MBOInstrumentFilter.hpp"
 #include "MBOParsed.hpp"
-#include "OrderBookManager.hpp"
+#include "BookRegistry.hpp"
+#include "StatsSegment.hpp"
+
+// Runtime options for the subscriber (set from the command line)
+struct SubscriberConfig {
+    // Shards, book threads and snapshot/journal outputs
+    RegistryConfig registry;
+    
+    // Instruments to subscribe to, as comma-separated instrument_ids
+    // and/or symbols (empty = all). Other instruments are filtered out on
+    // the publisher's side and never reach this process.
+    std::string instruments;
+
+    // Read MBOBatch samples from MBOBatchTopic (a publisher run with
+    // --batch) instead of single records from MBOTopic
+    bool batched = false;
+
+    // Print ingest stats and latencies every N seconds (0 = only at shutdown)
+    unsigned stats_interval_s = 0;
+
+    // Live counters go to /dev/shm/mbo_stats.<stats_name> for mbo_stat
+    // (empty = keep them in process)
+    std::string stats_name = kSubscriberStatsName;
+};
 
 class MBOSubscriber : public eprosima::fastdds::dds::DataReaderListener {
 private:
     eprosima::fastdds::dds::DomainParticipant* participant;
     eprosima::fastdds::dds::Subscriber* subscriber;
     eprosima::fastdds::dds::Topic* topic;
+    eprosima::fastdds::dds::ContentFilteredTopic* filtered_topic;
     eprosima::fastdds::dds::DataReader* reader;
     eprosima::fastdds::dds::TypeSupport type;
+    MBOInstrumentFilterFactory filter_factory;
+    
+    // Recovery requests back to the publisher, sent from run()
+    eprosima::fastdds::dds::Publisher* recovery_publisher;
+    eprosima::fastdds::dds::Topic* recovery_topic;
+    eprosima::fastdds::dds::DataWriter* recovery_writer;
+    eprosima::fastdds::dds::TypeSupport recovery_type;
+    uint64_t recovery_requests_sent;
     
     int matched_publishers;
-    int samples_received;
     
-    // OrderBook manager
-    std::unique_ptr<OrderBookManager> orderbook_mgr_;
+    SubscriberConfig config_;
+
+    // Live counters; declared before the registry, whose book threads
+    // write into it
+    StatsSegment stats_segment_;
+
+    // Listener counters and receive latency, in the segment if there is one
+    DispatchStats local_dispatch_stats_;
+    DispatchStats* dispatch_stats_;
+    
+    // Books per instrument, each shard fed by its own book thread
+    std::unique_ptr<BookRegistry> registry_;
 
 public:
-    MBOSubscriber();
+    explicit MBOSubscriber(const SubscriberConfig& config);
     ~MBOSubscriber();
     
     bool init();
+    
+    // Block until requestStop(), sending the shards' recovery requests
     void run();
     
+    // Ask run() to return; safe to call from a signal handler
+    static void requestStop();
+    
     // DataReaderListener callbacks
     void on_data_available(eprosima::fastdds::dds::DataReader* reader) override;
     void on_subscription_matched(
@@ -38,6 +90,15 @@ public:
         const eprosima::fastdds::dds::SubscriptionMatchedStatus& info) override;
     
 private:
-    MBOParsed parseCSVString(const std::string& csv_line);
-    void printRecord(const MBOParsed& r);
+    // Unpack batch samples and dispatch their records in order
+    void takeBatches(eprosima::fastdds::dds::DataReader* reader);
+
+    // Time sample from its ts_send to now_ns, if the publisher stamped it
+    void recordReceived(const MBOWire& sample, uint64_t now_ns);
+
+    // Write out every queued recovery request
+    void sendRecoveryRequests();
+
+    // Shard stats and latencies
+    void printStats(std::ostream& out) const;
 };
\ No newline at end of file
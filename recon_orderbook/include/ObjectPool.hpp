@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Slab allocator for fixed-size slots with an intrusive free list.
+// Slabs are sized up front (the expected high-water mark, rounded up to
+// a power of two) and only returned to the heap when the pool is
+// destroyed, so steady-state allocate/deallocate never touch malloc. If
+// the high-water mark is exceeded the pool grows by another slab of the
+// same size.
+//
+// Slots never handed out are carved off the slabs in order rather than
+// threaded onto the free list, which is what lets reset() take every
+// slot back at once.
+template <size_t SlotSize, size_t SlotAlign>
+class SlabPool {
+public:
+    explicit SlabPool(size_t capacity)
+        : free_(nullptr), next_(nullptr), slab_end_(nullptr), slab_(0),
+          slab_slots_(1), slab_shift_(0), in_use_(0), high_water_(0) {
+        while (slab_slots_ < capacity) {
+            slab_slots_ <<= 1;
+            ++slab_shift_;
+        }
+        grow();
+    }
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    void* allocate() {
+        Slot* slot = free_;
+        if (slot) {
+            free_ = slot->next;
+        } else {
+            if (next_ == slab_end_) {
+                nextSlab();
+            }
+            slot = next_++;
+        }
+        if (++in_use_ > high_water_) {
+            high_water_ = in_use_;
+        }
+        return slot;
+    }
+
+    void deallocate(void* ptr) {
+        Slot* slot = static_cast<Slot*>(ptr);
+        slot->next = free_;
+        free_ = slot;
+        --in_use_;
+    }
+
+    // Take back every slot, live or not, in constant time. Nothing is
+    // destroyed, so only for trivially destructible contents.
+    void reset() {
+        free_ = nullptr;
+        slab_ = 0;
+        next_ = slabs_.front().get();
+        slab_end_ = next_ + slab_slots_;
+        in_use_ = 0;
+    }
+
+    // Slots are also numbered (slab, then offset), so a slot can be named
+    // in 32 bits for as long as the pool lives
+    uint32_t slotNumber(const void* ptr) const {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+        for (size_t i = 0;; ++i) {
+            // A single slab unless the pool has grown
+            const uintptr_t base = reinterpret_cast<uintptr_t>(slabs_[i].get());
+            if (address - base < slab_slots_ * sizeof(Slot)) {
+                return static_cast<uint32_t>((i << slab_shift_) | (address - base) / sizeof(Slot));
+            }
+        }
+    }
+
+    void* slotAt(uint32_t number) const {
+        return slabs_[number >> slab_shift_].get() + (number & (slab_slots_ - 1));
+    }
+
+    size_t capacity() const { return slabs_.size() * slab_slots_; }
+    size_t inUse() const { return in_use_; }
+    size_t highWater() const { return high_water_; }
+    size_t slabCount() const { return slabs_.size(); }
+
+private:
+    union Slot {
+        Slot* next;
+        alignas(SlotAlign) unsigned char storage[SlotSize];
+    };
+
+    // Carve from the next slab, allocating one if every slab is in use
+    void nextSlab() {
+        if (slab_ + 1 < slabs_.size()) {
+            ++slab_;
+            next_ = slabs_[slab_].get();
+            slab_end_ = next_ + slab_slots_;
+        } else {
+            grow();
+        }
+    }
+
+    void grow() {
+        slabs_.emplace_back(new Slot[slab_slots_]);
+        slab_ = slabs_.size() - 1;
+        next_ = slabs_.back().get();
+        slab_end_ = next_ + slab_slots_;
+    }
+
+    std::vector<std::unique_ptr<Slot[]>> slabs_;
+    Slot* free_;
+    Slot* next_;            // next slot never handed out since the last reset
+    Slot* slab_end_;
+    size_t slab_;           // slab next_ carves from
+    size_t slab_slots_;
+    unsigned slab_shift_;   // log2(slab_slots_)
+    size_t in_use_;
+    size_t high_water_;
+};
+
+// Typed front end over a SlabPool
+template <typename T>
+class ObjectPool : public SlabPool<sizeof(T), alignof(T)> {
+public:
+    explicit ObjectPool(size_t capacity) : SlabPool<sizeof(T), alignof(T)>(capacity) {}
+
+    T* create(const T& value) {
+        return new (this->allocate()) T(value);
+    }
+
+    void destroy(T* obj) {
+        obj->~T();
+        this->deallocate(obj);
+    }
+
+    uint32_t handleOf(const T* obj) const { return this->slotNumber(obj); }
+    T* at(uint32_t handle) const { return static_cast<T*>(this->slotAt(handle)); }
+
+    // Every object at once, without running destructors
+    void reset() {
+        static_assert(std::is_trivially_destructible<T>::value, "reset() skips destructors");
+        SlabPool<sizeof(T), alignof(T)>::reset();
+    }
+};
+
+constexpr size_t alignUp(size_t size, size_t align) {
+    return (size + align - 1) / align * align;
+}
+
+// Slot size that fits one node of a node-based hash map holding V
+// (next pointer, value, optional cached hash code)
+template <typename V>
+constexpr size_t hashNodeSlotSize() {
+    return alignUp(sizeof(void*), alignof(V)) + alignUp(sizeof(V) + sizeof(size_t), alignof(V));
+}
+
+// std allocator that serves single-node allocations (hash map nodes) from a
+// shared SlabPool and passes everything else (bucket arrays) to the heap.
+// Reserve the container's buckets at startup and it stops allocating.
+template <typename T, size_t SlotSize, size_t SlotAlign>
+class PoolAllocator {
+public:
+    using value_type = T;
+    using Pool = SlabPool<SlotSize, SlotAlign>;
+
+    template <typename U>
+    struct rebind {
+        using other = PoolAllocator<U, SlotSize, SlotAlign>;
+    };
+
+    explicit PoolAllocator(Pool* pool) : pool_(pool) {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U, SlotSize, SlotAlign>& other) : pool_(other.pool()) {}
+
+    T* allocate(size_t n) {
+        if (fitsSlot(n)) {
+            return static_cast<T*>(pool_->allocate());
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        if (fitsSlot(n)) {
+            pool_->deallocate(ptr);
+            return;
+        }
+        ::operator delete(ptr, std::align_val_t(alignof(T)));
+    }
+
+    Pool* pool() const { return pool_; }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U, SlotSize, SlotAlign>& other) const { return pool_ == other.pool(); }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U, SlotSize, SlotAlign>& other) const { return pool_ != other.pool(); }
+
+private:
+    static bool fitsSlot(size_t n) {
+        return n == 1 && sizeof(T) <= SlotSize && alignof(T) <= SlotAlign;
+    }
+
+    Pool* pool_;
+};
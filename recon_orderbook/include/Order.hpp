@@ -1,29 +1,19 @@
 #pragma once
 
-#include <book/order.h>
-#include <string>
 #include <cstdint>
 
-using namespace liquibook;
+struct PriceLevel;
 
-class Order : public book::Order {
-public:
-    Order(bool is_buy, book::Price price, book::Quantity qty, 
-          uint64_t order_id = 0, const std::string& timestamp = "");
-    virtual ~Order() = default;
-    
-    virtual bool is_buy() const override;
-    virtual book::Price price() const override;
-    virtual book::Quantity order_qty() const override;
-    
-    // Getters for order metadata
-    uint64_t get_order_id() const { return order_id_; }
-    const std::string& get_timestamp() const { return timestamp_; }
+// Resting order node owned by MBOBook. Orders at one price level form an
+// intrusive FIFO through prev/next, and point straight at their level.
+struct Order {
+    uint64_t order_id;
+    int64_t price;          // ticks of the instrument's tick size
+    uint64_t timestamp;     // ts_event, ns since UNIX epoch
+    uint32_t qty;
+    bool is_buy;
 
-private:
-    bool is_buy_;
-    book::Price price_;
-    book::Quantity qty_;
-    uint64_t order_id_;
-    std::string timestamp_;
+    Order* prev;
+    Order* next;
+    PriceLevel* level;
 };
@@ -1,71 +1,155 @@
 #pragma once
 
 #include <string>
-#include <unordered_map>
 #include <memory>
 #include <iostream>
-#include <fstream>
+#include <vector>
 #include "MBOParsed.hpp"
-#include "Order.hpp"
-#include <book/depth_order_book.h>
-
-using namespace liquibook;
-
-// Structure to store order metadata
-struct OrderMetadata {
-    uint64_t order_id;
-    std::string timestamp;
-    double price;
-    uint32_t quantity;
-};
+#include "InstrumentTable.hpp"
+#include "MBOBook.hpp"
+#include "PendingCancels.hpp"
+#include "Snapshot.hpp"
+#include "SnapshotWriter.hpp"
+#include "Journal.hpp"
 
 class OrderBookManager {
 private:
-    // Liquibook orderbook instance
-    book::DepthOrderBook<Order*>* orderbook_;
-    
-    // Map external order_id to Liquibook Order pointer
-    std::unordered_map<uint64_t, Order*> order_map_;
+    // L3 mirror book, prices in ticks of tick_
+    MBOBook book_;
+    TickSize tick_;
+    uint64_t off_tick_prices_;
     
-    // Map to store order metadata (order_id -> metadata)
-    std::unordered_map<uint64_t, OrderMetadata> order_metadata_;
+    // Cancels that arrived before their order's add
+    PendingCancels pending_cancels_;
     
-    // Track pending cancels for out-of-order messages
-    std::unordered_map<uint64_t, MBOParsed> pending_cancels_;
-    
-    // Track symbol for JSON output
+    // Instrument this book belongs to, and its symbol for output
+    uint32_t instrument_id_;
     std::string current_symbol_;
     uint32_t current_sequence_;
     
-    // File stream for JSON output
-    std::ofstream json_file_;
+    // Publisher feed session the book's messages belong to (0 when the
+    // feed is unsequenced); journaled with every message
+    uint32_t feed_session_;
+    
+    // Last trade print and traded volume
+    int64_t last_trade_price_;
+    uint32_t last_trade_qty_;
+    uint64_t traded_volume_;
+    
+    // Apply 'F' fills to resting orders (see RegistryConfig::apply_fills)
+    bool fills_update_book_;
+    
+    // When to snapshot
+    SnapshotPolicy snapshot_policy_;
+    
+    // Snapshot policy state
+    uint64_t messages_since_snapshot_;
+    uint64_t last_snapshot_ts_;
+    TopOfBook last_top_;
+    
+    // Serialises and writes snapshots off the book thread (not owned;
+    // shared by the books of one shard)
+    SnapshotWriter* snapshot_writer_;
+    
+    // Binary snapshot/delta journal, if enabled (not owned, shared like
+    // the snapshot writer) and this book's journal snapshot cadence
+    JournalWriter* journal_;
+    uint64_t journal_snapshot_every_;
+    uint64_t messages_since_journal_snapshot_;
     
 public:
-    OrderBookManager();
-    ~OrderBookManager();
+    explicit OrderBookManager(size_t max_orders = kDefaultMaxOrders,
+                              size_t max_pending_cancels = kDefaultMaxPendingCancels,
+                              uint32_t instrument_id = 0,
+                              BookLayout layout = BookLayout::Sorted);
     
-    // Main entry point for processing MBO messages
+    // Main entry point for processing MBO messages: apply, then snapshot
+    // if the policy says so
     void processMessage(const MBOParsed& msg);
     
-    // Print current book state as JSON to terminal and file
-    void printBookStateJSON();
+    // Apply one message to the book without any output. Once the pools
+    // are warm this does no heap allocation.
+    void applyMessage(const MBOParsed& msg);
+    
+    // Copy the current book into a view and queue it for the snapshot
+    // writer. Never blocks; the snapshot is dropped if no slot is free.
+    void captureSnapshot();
+    
+    // Price grid of the instrument; set before the first message
+    void setTickSize(const TickSize& tick) { tick_ = tick; }
+    const TickSize& tickSize() const { return tick_; }
+    
+    // Snapshot configuration; without a writer snapshots are skipped
+    void setSnapshotPolicy(const SnapshotPolicy& policy) { snapshot_policy_ = policy; }
+    void setSnapshotWriter(SnapshotWriter* writer) { snapshot_writer_ = writer; }
     
-    // Initialize JSON file output
-    void initializeJSONFile(const std::string& filename);
+    // Whether 'F' fills reduce resting orders; off by default
+    void setApplyFills(bool apply) { fills_update_book_ = apply; }
+    
+    // How long an unmatched cancel is held for
+    void setPendingCancelAge(const PendingCancelAge& age) { pending_cancels_.setAge(age); }
+    const PendingCancels& pendingCancels() const { return pending_cancels_; }
+    
+    // Journal every processed message, with a full snapshot of this book
+    // every snapshot_every of its messages
+    void setJournal(JournalWriter* journal, uint64_t snapshot_every = kDefaultJournalSnapshotEvery) {
+        journal_ = journal;
+        journal_snapshot_every_ = snapshot_every;
+    }
+    
+    // Back to an empty book with no pending cancels or trade history
+    void reset();
+    
+    // Feed session of the messages that follow (after a reset, when the
+    // publisher starts over)
+    void setFeedSession(uint32_t feed_session) { feed_session_ = feed_session; }
+    uint32_t feedSession() const { return feed_session_; }
+    
+    // Replace all state with a journal snapshot: orders are bids then
+    // asks, in priority order. Pending cancels are restored one by one.
+    void restoreSnapshot(const JournalSnapshotHeader& snapshot, const JournalOrder* orders);
+    void restorePendingCancel(const PendingCancel& cancel) { pending_cancels_.insert(cancel); }
+    
+    const MBOBook& book() const { return book_; }
+    uint32_t instrumentId() const { return instrument_id_; }
+    const std::string& symbol() const { return current_symbol_; }
+    uint32_t sequence() const { return current_sequence_; }
+    
+    // Best bid/ask aggregates, maintained incrementally by the book.
+    // Book prices are in ticks (tickSize().toPrice() converts back).
+    TopOfBook getTopOfBook() const { return book_.topOfBook(); }
+    
+    // Top n aggregated levels per side, best first, prices in ticks
+    void getDepth(size_t n, std::vector<BookLevel>& bids, std::vector<BookLevel>& asks) const {
+        book_.depth(n, bids, asks);
+    }
+    
+    int64_t lastTradePrice() const { return last_trade_price_; }
+    uint32_t lastTradeQty() const { return last_trade_qty_; }
+    uint64_t tradedVolume() const { return traded_volume_; }
+    
+    // Order prices that weren't on the tick grid (rounded to the nearest tick)
+    uint64_t offTickPrices() const { return off_tick_prices_; }
     
 private:
     // Action handlers
     void handleAdd(const MBOParsed& msg);
     void handleCancel(const MBOParsed& msg);
     void handleModify(const MBOParsed& msg);
+    void handleClear();
     void handleTrade(const MBOParsed& msg);
+    void handleFill(const MBOParsed& msg);
+    
+    // msg's price in ticks, counting it if it is off the grid
+    int64_t ticksOf(const MBOParsed& msg);
     
-    // Helper to find order
-    Order* findOrder(uint64_t order_id);
+    // Decide whether msg should trigger a snapshot under the policy
+    bool snapshotDue(const MBOParsed& msg);
+    
+    // Append a full L3 snapshot (taken after msg) to the journal
+    void writeJournalSnapshot(const MBOParsed& msg);
+    void writeJournalSide(const BookSide& side);
     
     // Convert side character to boolean (true = buy, false = sell)
     bool convertSideToBool(char side);
-    
-    // Convert price to Liquibook format (scale if needed)
-    uint64_t convertPrice(double price);
-};
\ No newline at end of file
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Live orders of one book by order_id. A flat Robin Hood hash table of
+// 16-byte entries: the id, a 32-bit handle naming the order's slot in the
+// book's order pool, and the entry's distance from its home slot. A
+// search stops at the first entry nearer its home than the key would be
+// there. Erasing shifts the rest of the run back a slot, so
+// there are no tombstones. Entries also carry the epoch they were
+// inserted in: clear() starts a new epoch, and older entries count as
+// empty.
+//
+// The table for the full capacity is allocated up front. Past it (or on
+// a pathologically long probe run) the table doubles, rehashing every
+// entry.
+class OrderIndex {
+public:
+    static constexpr size_t npos = SIZE_MAX;
+
+    // Table for capacity orders at half load; past that it keeps
+    // doubling, allocating as it goes
+    explicit OrderIndex(size_t capacity);
+
+    // Position of order_id's entry, or npos
+    size_t find(uint64_t order_id) const {
+        size_t pos = home(order_id);
+        for (uint32_t dist = 0;; ++dist, pos = (pos + 1) & mask_) {
+            const Entry& entry = entries_[pos];
+            if (!live(entry) || distance(entry) < dist) {
+                return npos;
+            }
+            if (entry.order_id == order_id) {
+                return pos;
+            }
+        }
+    }
+
+    uint32_t handleAt(size_t pos) const { return entries_[pos].handle; }
+
+    // Add order_id; false (and nothing changes) if it is already there
+    bool insert(uint64_t order_id, uint32_t handle);
+
+    // Remove the entry at pos (from find())
+    void eraseAt(size_t pos);
+
+    // Remove every entry in constant time
+    void clear();
+
+    size_t size() const { return size_; }
+    size_t slots() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        uint64_t order_id;
+        uint32_t handle;
+        uint32_t meta;          // epoch << 8 | distance from the home slot
+    };
+
+    static constexpr uint32_t kMaxDistance = 0xff;
+    static constexpr uint32_t kMaxEpoch = 0xffffff;
+
+    size_t home(uint64_t order_id) const {
+        // Fibonacci hashing: order ids are mostly sequential
+        return static_cast<size_t>((order_id * 0x9E3779B97F4A7C15ull) >> shift_);
+    }
+
+    bool live(const Entry& entry) const { return (entry.meta >> 8) == epoch_; }
+    static uint32_t distance(const Entry& entry) { return entry.meta & kMaxDistance; }
+
+    // Place an id known not to be present, starting dist slots from its
+    // home at pos. False if a probe run got too long: the table must grow
+    // and entry (now possibly one it displaced) be placed again.
+    bool placeFrom(Entry& entry, size_t pos, uint32_t dist);
+
+    // Double the table and re-place every live entry
+    void grow();
+
+    // Empty table of slots entries (a power of two)
+    void allocate(size_t slots);
+
+    std::vector<Entry> entries_;
+    std::vector<Entry> moving_;     // live entries while the table grows
+    size_t mask_;
+    unsigned shift_;
+    size_t size_;
+    size_t max_size_;           // size_ that triggers grow()
+    uint32_t epoch_;
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Out-of-order cancels each book holds at most
+constexpr size_t kDefaultMaxPendingCancels = 16384;
+
+// How long a cancel may wait for its add. Most never get one: they are
+// for orders placed before we subscribed. Whichever limit is reached
+// first expires the cancel; 0 turns a limit off.
+struct PendingCancelAge {
+    uint64_t max_age_ns = 10000000000ull;       // exchange time (ts_event)
+    uint32_t max_age_sequences = 1000000;       // feed sequence numbers
+};
+
+// A cancel whose order isn't in the book yet
+struct PendingCancel {
+    uint64_t order_id;
+    uint64_t ts_event;
+    uint32_t sequence;
+    uint32_t qty;               // 0 cancels the whole order
+};
+
+// Fixed-capacity buffer of out-of-order cancels keyed by order id: an
+// open-addressing table (linear probing, backward-shift deletion, so no
+// tombstones) at most half full, plus a ring of insertion order. Cancels
+// past their age are expired from the old end of the ring as new
+// messages arrive; when the buffer is full the oldest one is evicted.
+// Memory is allocated once, in the constructor.
+class PendingCancels {
+public:
+    explicit PendingCancels(size_t capacity = kDefaultMaxPendingCancels,
+                            const PendingCancelAge& age = PendingCancelAge());
+
+    void setAge(const PendingCancelAge& age) { age_ = age; }
+    const PendingCancelAge& age() const { return age_; }
+
+    // Hold cancel (replacing one held for the same order)
+    void insert(const PendingCancel& cancel);
+
+    // An add for order_id arrived with sequence and ts_event: take the
+    // cancel held for it, unless there is none or it has expired
+    bool take(uint64_t order_id, uint32_t sequence, uint64_t ts_event, PendingCancel& cancel);
+
+    // Drop everything held (counters are kept)
+    void clear();
+
+    // Visit every cancel held, in no particular order
+    template <typename Visit>
+    void forEach(Visit&& visit) const {
+        for (const Slot& slot : slots_) {
+            if (slot.stamp != 0) {
+                visit(slot.cancel);
+            }
+        }
+    }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    size_t storageBytes() const { return slots_.size() * sizeof(Slot) + order_.size() * sizeof(Entry); }
+
+    uint64_t inserted() const { return inserted_; }
+    uint64_t matched() const { return matched_; }
+    uint64_t expired() const { return expired_; }      // reached their age
+    uint64_t evicted() const { return evicted_; }      // pushed out while the buffer was full
+
+private:
+    // stamp tells a slot's entry in order_ apart from older entries for
+    // the same order id; 0 marks an empty slot
+    struct Slot {
+        PendingCancel cancel;
+        uint32_t stamp;
+    };
+
+    // Insertion order: an entry is stale once its slot is gone or
+    // restamped. The ring has room for twice the capacity, and stale
+    // entries are compacted away when it fills up.
+    struct Entry {
+        uint64_t order_id;
+        uint32_t stamp;
+    };
+
+    size_t home(uint64_t order_id) const;
+
+    // Slot holding order_id, or SIZE_MAX
+    size_t find(uint64_t order_id) const;
+    void erase(size_t index);
+
+    bool tooOld(const PendingCancel& cancel, uint32_t sequence, uint64_t ts_event) const;
+
+    // Expire held cancels that are too old at (sequence, ts_event)
+    void expire(uint32_t sequence, uint64_t ts_event);
+
+    // Oldest entry of order_, with the slot it still owns (SIZE_MAX if stale)
+    size_t popOldest();
+
+    // Drop the stale entries of order_
+    void compact();
+
+    PendingCancelAge age_;
+    size_t capacity_;
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    unsigned shift_;
+    size_t size_;
+
+    std::vector<Entry> order_;
+    size_t head_;
+    size_t count_;
+    uint32_t next_stamp_;
+
+    uint64_t inserted_;
+    uint64_t matched_;
+    uint64_t expired_;
+    uint64_t evicted_;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "InstrumentTable.hpp"
+#include "MBOBook.hpp"
+
+// When OrderBookManager emits a book snapshot
+enum class SnapshotMode {
+    Off,            // never
+    EveryN,         // every N applied messages
+    Interval,       // at most once per T microseconds of event time
+    OnTopChange     // whenever best bid/ask price or size changes
+};
+
+struct SnapshotPolicy {
+    SnapshotMode mode = SnapshotMode::EveryN;
+    uint64_t every_n = 1;
+    uint64_t interval_us = 0;
+
+    // Parse "off", "top", "every:N" or "interval:T" (T in microseconds).
+    // Returns false on malformed input.
+    static bool parse(const std::string& spec, SnapshotPolicy& out);
+};
+
+// One resting order as captured for a snapshot
+struct OrderView {
+    uint64_t order_id;
+    uint64_t timestamp;
+    int64_t price;              // fixed-point, kPriceScale units
+    uint32_t qty;
+};
+
+// Immutable copy of the book. Views are reused, so the vectors keep
+// their capacity between snapshots.
+struct BookView {
+    uint32_t instrument_id;
+    std::string symbol;
+    uint32_t sequence;
+    unsigned price_decimals;        // fractional digits the tick size needs
+    TopOfBook top;                  // fixed-point prices
+    std::vector<OrderView> bids;    // best level first, queue order within a level
+    std::vector<OrderView> asks;
+};
+
+// Copy the book's orders and top of book into view, converting its tick
+// prices to fixed-point (instrument, symbol and sequence are left to the
+// caller)
+void captureBook(const MBOBook& book, const TickSize& tick, BookView& view);
+
+// Append view as the pretty-printed JSON snapshot document
+void appendSnapshotJSON(const BookView& view, std::string& out);
+
+// Destination for serialised snapshots. Sinks buffer internally; data is
+// only guaranteed to reach the OS after flush().
+class SnapshotSink {
+public:
+    virtual ~SnapshotSink() = default;
+    virtual void write(const char* data, size_t len) = 0;
+    virtual void flush() = 0;
+};
+
+// Sink over a stdio stream (file or stdout) that batches writes in its
+// own buffer and hands the OS one large write per buffer-full
+class StreamSnapshotSink : public SnapshotSink {
+public:
+    // Takes ownership of file unless it is stdout
+    StreamSnapshotSink(FILE* file, size_t buffer_size);
+    ~StreamSnapshotSink() override;
+
+    void write(const char* data, size_t len) override;
+    void flush() override;
+
+private:
+    void drain();
+
+    FILE* file_;
+    std::vector<char> buffer_;
+    size_t used_;
+};
+
+// Discards everything (snapshots still get built, e.g. for benchmarks)
+class NullSnapshotSink : public SnapshotSink {
+public:
+    void write(const char*, size_t) override {}
+    void flush() override {}
+};
+
+// Default stdio buffer for snapshot sinks
+constexpr size_t kSnapshotSinkBufferSize = 1 << 20;
+
+// Build a sink from "file:PATH", "stdout" or "none".
+// Returns nullptr (and reports why) on failure.
+std::unique_ptr<SnapshotSink> makeSnapshotSink(const std::string& spec);
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MBOBook.hpp"
+#include "Snapshot.hpp"
+#include "SPSCRing.hpp"
+
+// Book view slots shared between the ingest and writer threads
+constexpr size_t kDefaultSnapshotSlots = 4;
+
+// Serialises snapshots and writes them to the sinks on its own thread.
+// The ingest thread fills a free BookView slot and passes its index over
+// an SPSC ring; the writer hands slots back over a second ring, so
+// neither side ever takes a lock or waits on the other.
+//
+// When the writer falls behind it coalesces: of the queued views only the
+// newest of each instrument is written. When every slot is taken the new
+// snapshot is dropped.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(size_t slots = kDefaultSnapshotSlots);
+    ~SnapshotWriter();
+
+    // Sinks must be added before start()
+    void addSink(std::unique_ptr<SnapshotSink> sink) { sinks_.push_back(std::move(sink)); }
+    bool hasSinks() const { return !sinks_.empty(); }
+
+    void start();
+
+    // Write whatever is queued, flush the sinks and join the thread
+    void stop();
+
+    bool running() const { return running_.load(std::memory_order_relaxed); }
+
+    // Ingest side: a free slot to fill, or nullptr if none is free
+    // (the snapshot counts as dropped) or the writer isn't running
+    BookView* acquire();
+
+    // Ingest side: queue a slot returned by acquire()
+    void publish(BookView* view);
+
+    // Stats, readable from any thread
+    size_t queueDepth() const { return ready_.size(); }
+    size_t maxQueueDepth() const { return max_depth_.load(std::memory_order_relaxed); }
+    size_t slots() const { return views_.size(); }
+    uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+    uint64_t coalesced() const { return coalesced_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    void printStats(std::ostream& out) const;
+
+private:
+    void run();
+
+    // Write one view to every sink
+    void write(const BookView& view);
+
+    void flushSinks();
+
+    std::vector<BookView> views_;
+    SPSCRing<uint32_t> free_;     // writer -> ingest
+    SPSCRing<uint32_t> ready_;    // ingest -> writer
+
+    // Writer thread only
+    std::vector<std::unique_ptr<SnapshotSink>> sinks_;
+    std::string buffer_;
+    std::vector<uint32_t> pending_;     // newest queued slot per instrument
+
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    std::atomic<size_t> max_depth_;
+    std::atomic<uint64_t> written_;
+    std::atomic<uint64_t> coalesced_;
+    std::atomic<uint64_t> dropped_;
+};
@@ -0,0 +1,353 @@
+#include "BookRegistry.hpp"
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+// "snapshots.json" -> "snapshots.shard2.json" when there is more than one shard
+std::string shardPath(const std::string& path, size_t index, size_t shards) {
+    if (shards <= 1) {
+        return path;
+    }
+    const std::string suffix = ".shard" + std::to_string(index);
+    const size_t slash = path.find_last_of('/');
+    const size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || dot == 0 || (slash != std::string::npos && dot < slash)) {
+        return path + suffix;
+    }
+    return path.substr(0, dot) + suffix + path.substr(dot);
+}
+
+WorkerConfig shardWorkerConfig(const RegistryConfig& config, size_t index) {
+    WorkerConfig worker = config.worker;
+    if (worker.cpu >= 0) {
+        worker.cpu += static_cast<int>(index);
+    }
+    return worker;
+}
+
+uint64_t steadyNowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+BookShard::BookShard(size_t index, const RegistryConfig& config)
+    : index_(index), config_(config), last_instrument_(0), last_book_(nullptr),
+      recovery_(kRecoveryQueueSize), recovery_dropped_(0), stats_(&local_stats_), next_stats_ns_(0),
+      worker_(*this, shardWorkerConfig(config, index)) {
+}
+
+bool BookShard::init() {
+    for (const std::string& spec : config_.snapshot_sinks) {
+        const std::string shard_spec = spec.compare(0, 5, "file:") == 0
+            ? "file:" + shardPath(spec.substr(5), index_, config_.shards)
+            : spec;
+        std::unique_ptr<SnapshotSink> sink = makeSnapshotSink(shard_spec);
+        if (!sink) {
+            return false;
+        }
+        snapshot_writer_.addSink(std::move(sink));
+    }
+
+    if (!config_.journal_path.empty()) {
+        journal_ = std::make_unique<JournalWriter>();
+        if (!journal_->open(shardPath(config_.journal_path, index_, config_.shards))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BookShard::start() {
+    snapshot_writer_.start();
+    worker_.start();
+}
+
+void BookShard::stop() {
+    worker_.stop();
+    snapshot_writer_.stop();
+    if (journal_) {
+        journal_->close();
+    }
+    // The book thread is gone; leave final figures behind
+    publishGauges();
+}
+
+BookShard::Instrument& BookShard::instrumentFor(const MBOWire& sample) {
+    const uint32_t instrument_id = sample.instrument_id;
+    if (last_book_ && last_instrument_ == instrument_id) {
+        return *last_book_;
+    }
+
+    auto it = books_.find(instrument_id);
+    if (it == books_.end()) {
+        // First message for this instrument: the only allocation it costs
+        auto instrument = std::make_unique<Instrument>(config_, instrument_id);
+        OrderBookManager& book = instrument->book;
+        book.setTickSize(config_.instruments.lookup(instrument_id, sample.symbol));
+        book.setPendingCancelAge(config_.pending_cancel_age);
+        book.setApplyFills(config_.apply_fills);
+        book.setSnapshotPolicy(config_.snapshot_policy);
+        book.setSnapshotWriter(&snapshot_writer_);
+        if (journal_) {
+            book.setJournal(journal_.get(), config_.journal_snapshot_every);
+        }
+        it = books_.emplace(instrument_id, std::move(instrument)).first;
+    }
+    last_instrument_ = instrument_id;
+    last_book_ = it->second.get();
+    return *last_book_;
+}
+
+void BookShard::process(const MBOWire& sample) {
+    Instrument& instrument = instrumentFor(sample);
+    if (sample.feed_session == 0) {
+        // Unsequenced publisher: apply in arrival order
+        applyRecord(instrument.book, sample);
+        return;
+    }
+
+    FeedSequencer::Verdict verdict = instrument.feed.offer(sample);
+    if (verdict == FeedSequencer::Verdict::NewSession) {
+        // The publisher started over; so does the book
+        instrument.book.reset();
+        instrument.book.setFeedSession(sample.feed_session);
+        verdict = instrument.feed.offer(sample);
+    }
+    if (verdict == FeedSequencer::Verdict::Apply) {
+        apply(instrument, sample);
+    }
+
+    if (instrument.feed.gapOpen()) {
+        if (!instrument.gapped) {
+            instrument.gapped = true;
+            gapped_.push_back(&instrument);
+        }
+        pollGap(instrument, steadyNowNs());
+    }
+}
+
+void BookShard::apply(Instrument& instrument, const MBOWire& sample) {
+    applyRecord(instrument.book, sample);
+    MBOWire next;
+    while (instrument.feed.drain(next)) {
+        applyRecord(instrument.book, next);
+    }
+}
+
+void BookShard::applyRecord(OrderBookManager& book, const MBOWire& sample) {
+    stats_->records.add();
+    stats_->actions[statsAction(sample.action)].add();
+    if (sample.ts_send == 0) {
+        book.processMessage(fromWire(sample));
+        return;
+    }
+    const MBOParsed record = fromWire(sample);
+    const uint64_t parsed_ns = monotonicNowNs();
+    book.processMessage(record);
+    const uint64_t applied_ns = monotonicNowNs();
+    // A stamp from another host's clock can be ahead of ours
+    stats_->parsed.record(parsed_ns > sample.ts_send ? parsed_ns - sample.ts_send : 0);
+    stats_->applied.record(applied_ns > sample.ts_send ? applied_ns - sample.ts_send : 0);
+}
+
+void BookShard::pollGap(Instrument& instrument, uint64_t now_ns) {
+    MBORecoveryRequest request;
+    while (instrument.feed.poll(now_ns, request)) {
+        if (!recovery_.tryPush(request)) {
+            // The timer asks again
+            ++recovery_dropped_;
+        }
+    }
+    // A skipped gap lets kept records through
+    MBOWire next;
+    while (instrument.feed.drain(next)) {
+        applyRecord(instrument.book, next);
+    }
+}
+
+void BookShard::pollGaps() {
+    const uint64_t now_ns = steadyNowNs();
+    size_t kept = 0;
+    for (Instrument* instrument : gapped_) {
+        pollGap(*instrument, now_ns);
+        if (instrument->feed.gapOpen()) {
+            gapped_[kept++] = instrument;
+        } else {
+            instrument->gapped = false;
+        }
+    }
+    gapped_.resize(kept);
+}
+
+void BookShard::publishGauges() {
+    uint64_t off_tick = 0, orders = 0, bid_levels = 0, ask_levels = 0;
+    uint64_t sessions = 0, gaps = 0, reordered = 0, recovered = 0, unrecovered = 0, skipped = 0;
+    uint64_t duplicates = 0, diverged = 0, requests = 0;
+    uint64_t pending_held = 0, pending_inserted = 0, pending_matched = 0, pending_expired = 0, pending_evicted = 0;
+    for (const auto& entry : books_) {
+        const Instrument& instrument = *entry.second;
+        const MBOBook& book = instrument.book.book();
+        off_tick += instrument.book.offTickPrices();
+        orders += book.orderCount();
+        bid_levels += book.bids().levelCount();
+        ask_levels += book.asks().levelCount();
+
+        const FeedSequencer& feed = instrument.feed;
+        sessions += feed.sessions();
+        gaps += feed.gaps();
+        reordered += feed.reordered();
+        recovered += feed.recovered();
+        unrecovered += feed.unrecovered();
+        skipped += feed.skippedRecords();
+        duplicates += feed.duplicates();
+        diverged += feed.diverged();
+        requests += feed.requests();
+
+        const PendingCancels& pending = instrument.book.pendingCancels();
+        pending_held += pending.size();
+        pending_inserted += pending.inserted();
+        pending_matched += pending.matched();
+        pending_expired += pending.expired();
+        pending_evicted += pending.evicted();
+    }
+    stats_->books.set(books_.size());
+    stats_->off_tick_prices.set(off_tick);
+    stats_->live_orders.set(orders);
+    stats_->bid_levels.set(bid_levels);
+    stats_->ask_levels.set(ask_levels);
+    stats_->ring_depth.set(worker_.occupancy());
+    stats_->ring_high_water.set(worker_.highWater());
+    stats_->ring_capacity.set(worker_.capacity());
+    stats_->snapshots_out.set(snapshot_writer_.written());
+
+    stats_->sessions.set(sessions);
+    stats_->gaps.set(gaps);
+    stats_->reordered.set(reordered);
+    stats_->recovered.set(recovered);
+    stats_->unrecovered.set(unrecovered);
+    stats_->skipped_records.set(skipped);
+    stats_->duplicates.set(duplicates);
+    stats_->diverged.set(diverged);
+    stats_->recovery_requests.set(requests);
+    stats_->recovery_dropped.set(recovery_dropped_);
+
+    stats_->pending_cancels.set(pending_held);
+    stats_->pending_inserted.set(pending_inserted);
+    stats_->pending_matched.set(pending_matched);
+    stats_->pending_expired.set(pending_expired);
+    stats_->pending_evicted.set(pending_evicted);
+
+    if (journal_) {
+        stats_->journal_bytes.set(journal_->bytesWritten());
+        stats_->journal_snapshots.set(journal_->snapshots());
+        stats_->journal_stalls.set(journal_->stalls());
+    }
+}
+
+const OrderBookManager* BookShard::find(uint32_t instrument_id) const {
+    auto it = books_.find(instrument_id);
+    return it == books_.end() ? nullptr : &it->second->book;
+}
+
+bool BookShard::diverged(uint32_t instrument_id) const {
+    auto it = books_.find(instrument_id);
+    return it != books_.end() && it->second->feed.diverged();
+}
+
+void BookShard::printStats(std::ostream& out) const {
+    const ShardStats& stats = *stats_;
+    out << "Shard " << index_ << ": " << stats.books.get() << " books";
+    if (stats.off_tick_prices.get() > 0) {
+        out << ", " << stats.off_tick_prices.get() << " prices off the tick grid";
+    }
+    out << std::endl;
+    if (stats.sessions.get() > 0) {
+        out << "  Feed: " << stats.gaps.get() << " gaps (" << stats.reordered.get() << " reordered, "
+            << stats.recovered.get() << " recovered, " << stats.unrecovered.get() << " skipped losing "
+            << stats.skipped_records.get() << " records), " << stats.recovery_requests.get() << " recovery requests";
+        if (stats.recovery_dropped.get() > 0) {
+            out << " (" << stats.recovery_dropped.get() << " not queued)";
+        }
+        out << ", " << stats.duplicates.get() << " duplicates, " << stats.sessions.get() << " sessions, "
+            << stats.diverged.get() << " books diverged" << std::endl;
+    }
+    if (stats.pending_inserted.get() > 0) {
+        out << "  Pending cancels: " << stats.pending_cancels.get() << " held, " << stats.pending_inserted.get()
+            << " seen, " << stats.pending_matched.get() << " matched, " << stats.pending_expired.get()
+            << " expired, " << stats.pending_evicted.get() << " evicted" << std::endl;
+    }
+    if (stats.applied.count() > 0) {
+        LatencyHistogram latency;
+        stats.parsed.snapshot(latency);
+        out << "  Parsed since send: ";
+        printPercentiles(out, latency);
+        stats.applied.snapshot(latency);
+        out << std::endl << "  Applied since send (tick-to-book): ";
+        printPercentiles(out, latency);
+        out << std::endl;
+    }
+    out << "  ";
+    worker_.printStats(out);
+    out << "  ";
+    snapshot_writer_.printStats(out);
+    if (journal_) {
+        out << "  Journal: " << stats.journal_bytes.get() << " bytes, "
+            << stats.journal_snapshots.get() << " snapshots, " << stats.journal_stalls.get() << " stalls" << std::endl;
+    }
+}
+
+BookRegistry::BookRegistry(const RegistryConfig& config)
+    : config_(config) {
+    if (config_.shards == 0) {
+        config_.shards = 1;
+    }
+    for (size_t i = 0; i < config_.shards; ++i) {
+        shards_.push_back(std::make_unique<BookShard>(i, config_));
+    }
+}
+
+BookRegistry::~BookRegistry() {
+    stop();
+}
+
+void BookRegistry::setStats(StatsSegment& segment) {
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        shards_[i]->setStats(&segment.shard(i));
+    }
+}
+
+bool BookRegistry::init() {
+    for (auto& shard : shards_) {
+        if (!shard->init()) {
+            return false;
+        }
+    }
+    for (auto& shard : shards_) {
+        shard->start();
+    }
+    return true;
+}
+
+void BookRegistry::stop() {
+    for (auto& shard : shards_) {
+        shard->stop();
+    }
+}
+
+bool BookRegistry::takeRecoveryRequest(MBORecoveryRequest& request) {
+    for (auto& shard : shards_) {
+        if (shard->takeRecoveryRequest(request)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BookRegistry::printStats(std::ostream& out) const {
+    for (const auto& shard : shards_) {
+        shard->printStats(out);
+    }
+}
@@ -0,0 +1,144 @@
+#include "BookWorker.hpp"
+#include "BookRegistry.hpp"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+
+// Idle polls spent spinning, then yielding, before the thread sleeps
+constexpr unsigned kSpinPolls = 4096;
+constexpr unsigned kYieldPolls = 64;
+constexpr auto kIdleSleep = std::chrono::microseconds(50);
+
+// Samples between gap timer runs while the ring is busy
+constexpr uint64_t kGapPollEvery = 64;
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+} // namespace
+
+BookWorker::BookWorker(BookShard& shard, const WorkerConfig& config)
+    : shard_(shard), config_(config), ring_(config.ring_size), running_(false),
+      received_(0), dropped_(0), high_water_(0), processed_(0) {
+}
+
+BookWorker::~BookWorker() {
+    stop();
+}
+
+void BookWorker::start() {
+    if (running_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&BookWorker::run, this);
+}
+
+void BookWorker::stop() {
+    running_.store(false, std::memory_order_release);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool BookWorker::push(const MBOWire& sample) {
+    received_.store(received_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (!ring_.tryPush(sample)) {
+        dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const size_t depth = ring_.size();
+    if (depth > high_water_.load(std::memory_order_relaxed)) {
+        high_water_.store(depth, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void BookWorker::pushWait(const MBOWire& sample) {
+    received_.store(received_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    unsigned spins = 0;
+    while (!ring_.tryPush(sample)) {
+        // Give the book thread the core if it shares ours
+        if (++spins < kSpinPolls) {
+            cpuRelax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    const size_t depth = ring_.size();
+    if (depth > high_water_.load(std::memory_order_relaxed)) {
+        high_water_.store(depth, std::memory_order_relaxed);
+    }
+}
+
+void BookWorker::pin() {
+    if (config_.cpu < 0) {
+        return;
+    }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(config_.cpu, &cpus);
+    const int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (err != 0) {
+        std::cerr << "Failed to pin book thread to CPU " << config_.cpu << ": " << std::strerror(err) << std::endl;
+    }
+}
+
+void BookWorker::run() {
+    pin();
+
+    MBOWire sample;
+    unsigned idle = 0;
+
+    // Keep going after stop() until the ring is empty
+    while (running_.load(std::memory_order_acquire) || !ring_.empty()) {
+        if (ring_.tryPop(sample)) {
+            idle = 0;
+            shard_.process(sample);
+            const uint64_t processed = processed_.load(std::memory_order_relaxed) + 1;
+            processed_.store(processed, std::memory_order_relaxed);
+            if (processed % kGapPollEvery == 0) {
+                // Instruments that went quiet mid-gap time out too
+                shard_.poll();
+                shard_.refreshStats();
+            }
+            continue;
+        }
+
+        // Gaps time out even when nothing else arrives
+        shard_.poll();
+
+        if (config_.busy_poll || idle < kSpinPolls) {
+            // Not on every spin: reading the clock would slow the pickup
+            if (++idle % kSpinPolls == 0) {
+                shard_.refreshStats();
+            }
+            cpuRelax();
+        } else if (idle < kSpinPolls + kYieldPolls) {
+            ++idle;
+            std::this_thread::yield();
+        } else {
+            shard_.refreshStats();
+            std::this_thread::sleep_for(kIdleSleep);
+        }
+    }
+}
+
+void BookWorker::printStats(std::ostream& out) const {
+    out << "Ingest ring: received " << received()
+        << ", processed " << processed()
+        << ", dropped " << dropped()
+        << ", occupancy " << occupancy() << "/" << capacity()
+        << " (high water " << highWater() << ")" << std::endl;
+}
@@ -0,0 +1,233 @@
+#include "FeedSequencer.hpp"
+
+namespace {
+
+uint32_t windowSize(size_t capacity) {
+    uint32_t size = 1;
+    while (size < capacity && size < (1u << 30)) {
+        size <<= 1;
+    }
+    return size;
+}
+
+uint64_t toNs(std::chrono::microseconds us) {
+    return static_cast<uint64_t>(us.count()) * 1000;
+}
+
+} // namespace
+
+FeedSequencer::FeedSequencer(const SequencerConfig& config)
+    : config_(config), window_(windowSize(config.reorder_capacity), MBOWire{}),
+      mask_(static_cast<uint32_t>(window_.size() - 1)),
+      instrument_id_(0), session_(0), expected_(1), highest_(0), lowest_overflow_(UINT32_MAX),
+      gap_open_(false), requested_(false), skipped_(false), issuing_(false),
+      gap_started_ns_(0), request_sent_ns_(0), tail_started_ns_(0), attempts_(0),
+      requested_to_(0), progress_mark_(0), cursor_(0),
+      diverged_(false), sessions_(0), gaps_(0), reordered_(0), recovered_(0), unrecovered_(0),
+      skipped_records_(0), requests_(0), duplicates_(0), overflows_(0) {
+}
+
+FeedSequencer::Verdict FeedSequencer::offer(const MBOWire& sample) {
+    if (sample.feed_session != session_) {
+        // Publisher restarted (or this is the first record): numbering
+        // starts over and whatever was kept belongs to the old session
+        instrument_id_ = sample.instrument_id;
+        session_ = sample.feed_session;
+        expected_ = 1;
+        highest_ = 0;
+        lowest_overflow_ = UINT32_MAX;
+        gap_open_ = false;
+        requested_ = false;
+        skipped_ = false;
+        issuing_ = false;
+        gap_started_ns_ = 0;
+        diverged_ = false;
+        ++sessions_;
+        return Verdict::NewSession;
+    }
+
+    const uint32_t sequence = sample.feed_sequence;
+    if (sequence < expected_) {
+        ++duplicates_;
+        return Verdict::Dropped;
+    }
+    if (sequence > highest_) {
+        highest_ = sequence;
+    }
+    if (sequence == expected_) {
+        ++expected_;
+        return Verdict::Apply;
+    }
+
+    if (!gap_open_) {
+        gap_open_ = true;
+        skipped_ = false;
+        gap_started_ns_ = 0;
+        ++gaps_;
+    }
+    if (sequence - expected_ > mask_) {
+        // Beyond the window; asked for again once the window gets there
+        ++overflows_;
+        if (sequence < lowest_overflow_) {
+            lowest_overflow_ = sequence;
+        }
+        return Verdict::Dropped;
+    }
+    window_[sequence & mask_] = sample;
+    return Verdict::Held;
+}
+
+bool FeedSequencer::drain(MBOWire& sample) {
+    MBOWire& slot = window_[expected_ & mask_];
+    if (expected_ <= highest_ && slot.feed_sequence == expected_ && slot.feed_session == session_) {
+        sample = slot;
+        slot.feed_sequence = 0;
+        ++expected_;
+        return true;
+    }
+
+    if (gap_open_ && expected_ > highest_) {
+        // Caught up with everything seen
+        if (skipped_) {
+            // Already counted as unrecovered
+        } else if (requested_) {
+            ++recovered_;
+        } else {
+            ++reordered_;
+        }
+        gap_open_ = false;
+        requested_ = false;
+        skipped_ = false;
+        issuing_ = false;
+    }
+    return false;
+}
+
+bool FeedSequencer::kept(uint32_t sequence) const {
+    if (sequence - expected_ > mask_) {
+        return false;
+    }
+    const MBOWire& slot = window_[sequence & mask_];
+    return slot.feed_sequence == sequence && slot.feed_session == session_;
+}
+
+uint32_t FeedSequencer::windowEnd() const {
+    return highest_ - expected_ > mask_ ? expected_ + mask_ : highest_;
+}
+
+void FeedSequencer::startRequests(uint32_t from, uint64_t now_ns) {
+    // Only what the window can keep: the rest is asked for as it drains
+    cursor_ = from;
+    requested_to_ = windowEnd();
+    request_sent_ns_ = now_ns;
+    progress_mark_ = expected_;
+    tail_started_ns_ = 0;
+    issuing_ = true;
+}
+
+bool FeedSequencer::nextRequest(MBORecoveryRequest& request) {
+    // Next run of missing sequences up to requested_to_; one request each
+    uint32_t from = cursor_ > expected_ ? cursor_ : expected_;
+    while (from <= requested_to_ && kept(from)) {
+        ++from;
+    }
+    if (from > requested_to_) {
+        issuing_ = false;
+        return false;
+    }
+    uint32_t to = from;
+    while (to < requested_to_ && !kept(to + 1)) {
+        ++to;
+    }
+
+    cursor_ = to + 1;
+    ++requests_;
+    request = MBORecoveryRequest{instrument_id_, session_, from, to};
+    return true;
+}
+
+bool FeedSequencer::poll(uint64_t now_ns, MBORecoveryRequest& request) {
+    if (!gap_open_) {
+        return false;
+    }
+    if (issuing_) {
+        return nextRequest(request);
+    }
+    if (gap_started_ns_ == 0) {
+        gap_started_ns_ = now_ns;
+    }
+
+    if (!requested_) {
+        // A gap wider than the window is a loss, not a reorder: ask now
+        if (highest_ - expected_ <= mask_ && now_ns - gap_started_ns_ < toNs(config_.gap_timeout)) {
+            return false;
+        }
+        if (skipped_) {
+            // What a skip left behind is worth asking for on its own
+            skipped_ = false;
+            ++gaps_;
+        }
+        requested_ = true;
+        attempts_ = 1;
+        startRequests(expected_, now_ns);
+    } else if (expected_ != progress_mark_) {
+        // Resends are arriving; give the rest of them time
+        progress_mark_ = expected_;
+        request_sent_ns_ = now_ns;
+        attempts_ = 1;
+        return false;
+    } else if (windowEnd() > requested_to_) {
+        // Records arrived past the last request, or the window moved on
+        // over records it had no room for. Holes there get the same grace
+        // as a new gap, unless the window overflowed and they are known lost.
+        if (tail_started_ns_ == 0) {
+            tail_started_ns_ = now_ns;
+        }
+        if (highest_ - expected_ <= mask_ && now_ns - tail_started_ns_ < toNs(config_.gap_timeout)) {
+            return false;
+        }
+        const uint64_t sent_ns = request_sent_ns_;
+        startRequests(requested_to_ + 1, now_ns);
+        // The earlier request's timeout still runs
+        request_sent_ns_ = sent_ns;
+    } else if (now_ns - request_sent_ns_ >= toNs(config_.recovery_timeout)) {
+        if (attempts_ >= config_.max_recovery_attempts) {
+            skipGap();
+            return false;
+        }
+        ++attempts_;
+        startRequests(expected_, now_ns);
+    } else {
+        return false;
+    }
+    return nextRequest(request);
+}
+
+void FeedSequencer::skipGap() {
+    // Resume at the first record known to have been sent after the gap:
+    // the next one kept, or else the first the window had no room for
+    // (dropped here, so still worth asking for)
+    const uint32_t from = expected_;
+    uint32_t next = lowest_overflow_ > expected_ && lowest_overflow_ <= highest_ ? lowest_overflow_ : highest_ + 1;
+    const uint32_t last = windowEnd();
+    for (uint32_t sequence = expected_ + 1; sequence <= last; ++sequence) {
+        const MBOWire& slot = window_[sequence & mask_];
+        if (slot.feed_sequence == sequence && slot.feed_session == session_) {
+            next = sequence;
+            break;
+        }
+    }
+
+    expected_ = next;
+    lowest_overflow_ = UINT32_MAX;
+    skipped_records_ += next - from;
+    ++unrecovered_;
+    diverged_ = true;
+
+    // Whatever lies past the next kept record is a new gap, timed afresh
+    gap_open_ = expected_ <= highest_;
+    skipped_ = gap_open_;
+    requested_ = false;
+    issuing_ = false;
+    gap_started_ns_ = 0;
+}
@@ -0,0 +1,175 @@
+#include "InstrumentTable.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+// Fractional digits needed to print every multiple of tick exactly
+unsigned tickDecimals(int64_t tick) {
+    unsigned decimals = 9;
+    while (decimals > 0 && tick % 10 == 0) {
+        tick /= 10;
+        --decimals;
+    }
+    return decimals;
+}
+
+bool allDigits(const std::string& text) {
+    if (text.empty()) {
+        return false;
+    }
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string trim(const std::string& text) {
+    const size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) {
+        return std::string();
+    }
+    const size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+} // namespace
+
+int64_t parseTickSize(const char* text, size_t len) {
+    int64_t whole = 0;
+    int64_t fraction = 0;
+    unsigned digits = 0;
+    size_t pos = 0;
+    for (; pos < len && text[pos] >= '0' && text[pos] <= '9'; ++pos) {
+        whole = whole * 10 + (text[pos] - '0');
+        if (whole > 1000000000) {
+            return 0;
+        }
+    }
+    if (pos < len && text[pos] == '.') {
+        for (++pos; pos < len && text[pos] >= '0' && text[pos] <= '9'; ++pos) {
+            if (++digits > 9) {
+                return 0;
+            }
+            fraction = fraction * 10 + (text[pos] - '0');
+        }
+    }
+    if (pos != len || len == 0) {
+        return 0;
+    }
+    for (; digits < 9; ++digits) {
+        fraction *= 10;
+    }
+    return whole * kPriceScale + fraction;
+}
+
+size_t formatPrice(int64_t price, unsigned decimals, char* out, size_t len) {
+    const bool negative = price < 0;
+    const uint64_t magnitude = negative ? 0 - static_cast<uint64_t>(price) : static_cast<uint64_t>(price);
+    const uint64_t whole = magnitude / kPriceScale;
+    uint64_t fraction = magnitude % kPriceScale;
+
+    // Drop trailing zeros the caller didn't ask for
+    unsigned digits = 9;
+    if (decimals > 9) {
+        decimals = 9;
+    }
+    while (digits > decimals && fraction % 10 == 0) {
+        fraction /= 10;
+        --digits;
+    }
+
+    const int n = digits > 0
+        ? std::snprintf(out, len, "%s%llu.%0*llu", negative ? "-" : "", static_cast<unsigned long long>(whole),
+                        static_cast<int>(digits), static_cast<unsigned long long>(fraction))
+        : std::snprintf(out, len, "%s%llu", negative ? "-" : "", static_cast<unsigned long long>(whole));
+    if (n < 0) {
+        return 0;
+    }
+    return static_cast<size_t>(n) < len ? static_cast<size_t>(n) : len - 1;
+}
+
+std::string formatPrice(int64_t price, unsigned decimals) {
+    char buf[32];
+    const size_t n = formatPrice(price, decimals, buf, sizeof(buf));
+    return std::string(buf, n);
+}
+
+bool InstrumentTable::add(const std::string& key, int64_t tick) {
+    if (key.empty() || tick <= 0) {
+        return false;
+    }
+
+    Entry entry{0, std::string(), false, TickSize{tick, tickDecimals(tick)}};
+    if (allDigits(key)) {
+        if (key.size() > 10 || std::stoull(key) > UINT32_MAX || std::stoull(key) == 0) {
+            return false;
+        }
+        entry.instrument_id = static_cast<uint32_t>(std::stoul(key));
+    } else {
+        entry.root = key.back() == '*';
+        entry.symbol = entry.root ? key.substr(0, key.size() - 1) : key;
+        if (entry.symbol.empty() || entry.symbol.size() > kSymbolLen) {
+            return false;
+        }
+    }
+    entries_.push_back(entry);
+    return true;
+}
+
+bool InstrumentTable::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Error opening instrument definitions: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    size_t number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        const size_t comma = line.find(',');
+        const std::string key = comma == std::string::npos ? line : trim(line.substr(0, comma));
+        const std::string tick = comma == std::string::npos ? std::string() : trim(line.substr(comma + 1));
+        if (!add(key, parseTickSize(tick.data(), tick.size()))) {
+            std::cerr << path << ":" << number << ": invalid instrument definition: " << line << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+TickSize InstrumentTable::lookup(uint32_t instrument_id, const char* symbol) const {
+    const size_t symbol_len = symbol ? strnlen(symbol, kSymbolLen) : 0;
+    const Entry* by_symbol = nullptr;
+    const Entry* by_root = nullptr;
+
+    for (const Entry& entry : entries_) {
+        if (entry.instrument_id != 0) {
+            if (entry.instrument_id == instrument_id) {
+                return entry.tick;
+            }
+        } else if (!entry.root) {
+            if (!by_symbol && entry.symbol.size() == symbol_len &&
+                std::memcmp(entry.symbol.data(), symbol, symbol_len) == 0) {
+                by_symbol = &entry;
+            }
+        } else if (entry.symbol.size() <= symbol_len &&
+                   std::memcmp(entry.symbol.data(), symbol, entry.symbol.size()) == 0 &&
+                   (!by_root || entry.symbol.size() > by_root->symbol.size())) {
+            by_root = &entry;
+        }
+    }
+    if (by_symbol) {
+        return by_symbol->tick;
+    }
+    return by_root ? by_root->tick : TickSize{};
+}
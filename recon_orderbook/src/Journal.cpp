@@ -0,0 +1,384 @@
+#include "Journal.hpp"
+#include "OrderBookManager.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+JournalWriter::JournalWriter()
+    : fd_(-1), offset_(0), stalls_(0), delta_count_(0), first_sequence_(0), last_sequence_(0), last_session_(0),
+      current_(0), free_(kJournalBuffers), full_(kJournalBuffers),
+      running_(false), failed_(false) {
+}
+
+JournalWriter::~JournalWriter() {
+    close();
+}
+
+bool JournalWriter::open(const std::string& path) {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "Error opening journal: " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    buffers_.resize(kJournalBuffers);
+    for (uint32_t i = 0; i < buffers_.size(); ++i) {
+        buffers_[i].data.resize(kJournalBufferSize);
+        buffers_[i].used = 0;
+        if (i != current_) {
+            free_.tryPush(i);
+        }
+    }
+
+    JournalFileHeader header{};
+    std::memcpy(header.magic, kJournalMagic, sizeof(header.magic));
+    header.version = kJournalVersion;
+    header.header_size = sizeof(header);
+    append(&header, sizeof(header));
+
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&JournalWriter::run, this);
+    return true;
+}
+
+void JournalWriter::close() {
+    if (fd_ < 0) {
+        return;
+    }
+
+    // Trailing index so readers can seek without scanning
+    JournalFooter footer{};
+    footer.index_offset = offset_;
+    footer.index_count = index_.size();
+    footer.delta_count = delta_count_;
+    footer.first_sequence = first_sequence_;
+    footer.last_sequence = last_sequence_;
+    footer.last_session = last_session_;
+    std::memcpy(footer.magic, kJournalIndexMagic, sizeof(footer.magic));
+    if (!index_.empty()) {
+        append(index_.data(), index_.size() * sizeof(JournalIndexEntry));
+    }
+    append(&footer, sizeof(footer));
+    if (buffers_[current_].used > 0) {
+        submit();
+    }
+
+    running_.store(false, std::memory_order_release);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    ::close(fd_);
+    fd_ = -1;
+}
+
+void JournalWriter::appendDelta(const MBOParsed& msg, uint32_t feed_session) {
+    const JournalRecordHeader header{static_cast<uint32_t>(JournalRecordType::Delta),
+                                     sizeof(JournalDeltaHeader) + sizeof(MBOParsed)};
+    const JournalDeltaHeader delta{feed_session, 0};
+    append(&header, sizeof(header));
+    append(&delta, sizeof(delta));
+    append(&msg, sizeof(msg));
+
+    if (delta_count_ == 0) {
+        first_sequence_ = msg.sequence;
+    }
+    last_sequence_ = msg.sequence;
+    last_session_ = feed_session;
+    ++delta_count_;
+}
+
+void JournalWriter::beginSnapshot(const JournalSnapshotHeader& snapshot) {
+    const size_t length = sizeof(snapshot)
+        + (static_cast<size_t>(snapshot.bid_orders) + snapshot.ask_orders) * sizeof(JournalOrder)
+        + static_cast<size_t>(snapshot.pending_cancels) * sizeof(PendingCancel);
+    index_.push_back(JournalIndexEntry{offset_, snapshot.ts_event, snapshot.sequence, snapshot.instrument_id,
+                                       snapshot.feed_session, 0});
+
+    const JournalRecordHeader header{static_cast<uint32_t>(JournalRecordType::Snapshot),
+                                     static_cast<uint32_t>(length)};
+    append(&header, sizeof(header));
+    append(&snapshot, sizeof(snapshot));
+}
+
+void JournalWriter::append(const void* data, size_t len) {
+    const char* src = static_cast<const char*>(data);
+    offset_ += len;
+    while (len > 0) {
+        Buffer& buffer = buffers_[current_];
+        const size_t n = std::min(len, buffer.data.size() - buffer.used);
+        std::memcpy(buffer.data.data() + buffer.used, src, n);
+        buffer.used += n;
+        src += n;
+        len -= n;
+        if (buffer.used == buffer.data.size()) {
+            submit();
+        }
+    }
+}
+
+void JournalWriter::submit() {
+    // Can't fail: there are as many ring entries as buffers
+    full_.tryPush(current_);
+
+    if (!free_.tryPop(current_)) {
+        // The disk is a full set of buffers behind; journal data can't be
+        // dropped, so wait for the I/O thread
+        ++stalls_;
+        while (!free_.tryPop(current_)) {
+            std::this_thread::yield();
+        }
+    }
+    buffers_[current_].used = 0;
+}
+
+void JournalWriter::run() {
+    while (running_.load(std::memory_order_acquire) || !full_.empty()) {
+        uint32_t index;
+        if (!full_.tryPop(index)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+
+        const Buffer& buffer = buffers_[index];
+        size_t written = 0;
+        while (written < buffer.used && !failed_.load(std::memory_order_relaxed)) {
+            const ssize_t n = ::write(fd_, buffer.data.data() + written, buffer.used - written);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "Journal write failed: " << std::strerror(errno) << std::endl;
+                failed_.store(true, std::memory_order_relaxed);
+                break;
+            }
+            written += static_cast<size_t>(n);
+        }
+        free_.tryPush(index);
+    }
+}
+
+JournalReader::JournalReader()
+    : fd_(-1), data_(nullptr), size_(0), records_end_(0),
+      delta_count_(0), first_sequence_(0), last_sequence_(0), last_session_(0), first_instrument_(0) {
+}
+
+JournalReader::~JournalReader() {
+    close();
+}
+
+bool JournalReader::open(const std::string& path) {
+    close();
+
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        std::cerr << "Error opening journal: " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(JournalFileHeader)) {
+        std::cerr << "Not a journal: " << path << std::endl;
+        close();
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+
+    void* map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (map == MAP_FAILED) {
+        std::cerr << "Error mapping journal: " << path << ": " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    data_ = static_cast<const char*>(map);
+
+    JournalFileHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, kJournalMagic, sizeof(header.magic)) != 0 ||
+        header.version != kJournalVersion || header.header_size != sizeof(header)) {
+        std::cerr << "Not a journal (or unsupported version): " << path << std::endl;
+        close();
+        return false;
+    }
+
+    // Use the trailing index if the writer closed the journal cleanly
+    if (size_ >= sizeof(JournalFileHeader) + sizeof(JournalFooter)) {
+        JournalFooter footer;
+        std::memcpy(&footer, data_ + size_ - sizeof(footer), sizeof(footer));
+        if (std::memcmp(footer.magic, kJournalIndexMagic, sizeof(footer.magic)) == 0 &&
+            footer.index_offset + footer.index_count * sizeof(JournalIndexEntry) + sizeof(footer) == size_) {
+            const JournalIndexEntry* entries = reinterpret_cast<const JournalIndexEntry*>(data_ + footer.index_offset);
+            index_.assign(entries, entries + footer.index_count);
+            records_end_ = footer.index_offset;
+            delta_count_ = footer.delta_count;
+            first_sequence_ = footer.first_sequence;
+            last_sequence_ = footer.last_sequence;
+            last_session_ = footer.last_session;
+            readFirstInstrument();
+            return true;
+        }
+    }
+
+    std::cerr << "Journal has no index (writer did not close it), scanning" << std::endl;
+    scan();
+    readFirstInstrument();
+    return true;
+}
+
+void JournalReader::readFirstInstrument() {
+    uint64_t offset = sizeof(JournalFileHeader);
+    while (offset + sizeof(JournalRecordHeader) <= records_end_) {
+        const JournalRecordHeader* record = recordAt(offset);
+        if (record->type == static_cast<uint32_t>(JournalRecordType::Delta)) {
+            JournalDeltaHeader delta;
+            MBOParsed msg;
+            readDelta(record, delta, msg);
+            first_instrument_ = msg.instrument_id;
+            return;
+        }
+        offset += sizeof(JournalRecordHeader) + record->length;
+    }
+}
+
+void JournalReader::close() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    size_ = 0;
+    records_end_ = 0;
+    index_.clear();
+    delta_count_ = 0;
+    last_session_ = 0;
+}
+
+void JournalReader::scan() {
+    uint64_t offset = sizeof(JournalFileHeader);
+    while (offset + sizeof(JournalRecordHeader) <= size_) {
+        const JournalRecordHeader* record = recordAt(offset);
+        const uint64_t end = offset + sizeof(JournalRecordHeader) + record->length;
+        if (end > size_) {
+            // Truncated tail from an interrupted write
+            break;
+        }
+
+        if (record->type == static_cast<uint32_t>(JournalRecordType::Delta)) {
+            JournalDeltaHeader delta;
+            MBOParsed msg;
+            readDelta(record, delta, msg);
+            if (delta_count_ == 0) {
+                first_sequence_ = msg.sequence;
+            }
+            last_sequence_ = msg.sequence;
+            last_session_ = delta.feed_session;
+            ++delta_count_;
+        } else if (record->type == static_cast<uint32_t>(JournalRecordType::Snapshot)) {
+            const JournalSnapshotHeader* snapshot = reinterpret_cast<const JournalSnapshotHeader*>(record + 1);
+            index_.push_back(JournalIndexEntry{offset, snapshot->ts_event, snapshot->sequence, snapshot->instrument_id,
+                                               snapshot->feed_session, 0});
+        } else {
+            // Hit the trailing index of a journal with a damaged footer
+            break;
+        }
+        offset = end;
+    }
+    records_end_ = offset;
+}
+
+size_t JournalReader::rebuildAtSequence(uint32_t instrument_id, uint32_t feed_session, uint32_t target,
+                                        OrderBookManager& manager) const {
+    return rebuild(instrument_id, feed_session, target, false, manager);
+}
+
+size_t JournalReader::rebuildAtTime(uint32_t instrument_id, uint32_t feed_session, uint64_t target,
+                                    OrderBookManager& manager) const {
+    return rebuild(instrument_id, feed_session, target, true, manager);
+}
+
+size_t JournalReader::rebuild(uint32_t instrument_id, uint32_t feed_session, uint64_t target, bool by_time,
+                              OrderBookManager& manager) const {
+    // Latest snapshot of this instrument and session at or before target.
+    // Sequences and times only rise within a session, and the sessions of
+    // different instruments interleave, so the index as a whole isn't
+    // sorted; it holds one entry per snapshot, so walk it from the end.
+    auto start = index_.rend();
+    for (auto it = index_.rbegin(); it != index_.rend(); ++it) {
+        if (it->instrument_id == instrument_id && it->feed_session == feed_session &&
+            (by_time ? it->ts_event : it->sequence) <= target) {
+            start = it;
+            break;
+        }
+    }
+
+    uint64_t offset = sizeof(JournalFileHeader);
+    bool in_session = false;
+    if (start == index_.rend()) {
+        manager.reset();
+    } else {
+        loadSnapshot(start->offset, manager);
+        offset = start->offset + sizeof(JournalRecordHeader) + recordAt(start->offset)->length;
+        in_session = true;
+    }
+
+    // Replay this instrument's deltas of the session up to target
+    size_t applied = 0;
+    JournalDeltaHeader delta;
+    MBOParsed msg;
+    while (offset + sizeof(JournalRecordHeader) <= records_end_) {
+        const JournalRecordHeader* record = recordAt(offset);
+        offset += sizeof(JournalRecordHeader) + record->length;
+        if (record->type != static_cast<uint32_t>(JournalRecordType::Delta)) {
+            continue;
+        }
+        readDelta(record, delta, msg);
+        if (msg.instrument_id != instrument_id) {
+            continue;
+        }
+        if (delta.feed_session != feed_session) {
+            if (in_session) {
+                // The session ended before reaching target
+                break;
+            }
+            // An earlier session of this instrument
+            continue;
+        }
+        in_session = true;
+        if ((by_time ? msg.ts_event : msg.sequence) > target) {
+            break;
+        }
+        manager.applyMessage(msg);
+        ++applied;
+    }
+    manager.setFeedSession(feed_session);
+    return applied;
+}
+
+void JournalReader::readDelta(const JournalRecordHeader* record, JournalDeltaHeader& delta, MBOParsed& msg) {
+    // Records are only 8-byte aligned; MBOParsed wants a cache line
+    const char* payload = reinterpret_cast<const char*>(record + 1);
+    std::memcpy(&delta, payload, sizeof(delta));
+    std::memcpy(&msg, payload + sizeof(delta), sizeof(msg));
+}
+
+void JournalReader::loadSnapshot(uint64_t offset, OrderBookManager& manager) const {
+    const JournalRecordHeader* record = recordAt(offset);
+    const JournalSnapshotHeader* snapshot = reinterpret_cast<const JournalSnapshotHeader*>(record + 1);
+    const JournalOrder* orders = reinterpret_cast<const JournalOrder*>(snapshot + 1);
+    manager.restoreSnapshot(*snapshot, orders);
+
+    const char* pending = reinterpret_cast<const char*>(orders + snapshot->bid_orders + snapshot->ask_orders);
+    PendingCancel cancel;
+    for (uint32_t i = 0; i < snapshot->pending_cancels; ++i) {
+        std::memcpy(&cancel, pending + i * sizeof(PendingCancel), sizeof(cancel));
+        manager.restorePendingCancel(cancel);
+    }
+}
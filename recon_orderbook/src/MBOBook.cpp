@@ -0,0 +1,315 @@
+#include "MBOBook.hpp"
+#include <algorithm>
+
+BookSide::BookSide(bool is_buy, size_t max_levels, BookLayout layout)
+    : is_buy_(is_buy), ladder_(layout == BookLayout::Ladder), level_pool_(max_levels),
+      base_(0), window_levels_(0), best_slot_(0), bits_{}, summary_(0) {
+    levels_.reserve(max_levels);
+    if (ladder_) {
+        slots_.assign(kLadderTicks, nullptr);
+    }
+}
+
+std::vector<BookSide::Entry>::iterator BookSide::lowerBound(int64_t price) {
+    // Array is sorted worst -> best: ascending for bids, descending for asks
+    if (is_buy_) {
+        return std::lower_bound(levels_.begin(), levels_.end(), price,
+            [](const Entry& e, int64_t p) { return e.price < p; });
+    }
+    return std::lower_bound(levels_.begin(), levels_.end(), price,
+        [](const Entry& e, int64_t p) { return e.price > p; });
+}
+
+PriceLevel* BookSide::findOrCreate(int64_t price) {
+    return ladder_ ? ladderFindOrCreate(price) : sortedFindOrCreate(price);
+}
+
+void BookSide::removeLevel(PriceLevel* level) {
+    if (ladder_) {
+        ladderRemove(level);
+    } else {
+        sortedRemove(level);
+    }
+}
+
+PriceLevel* BookSide::sortedFindOrCreate(int64_t price) {
+    // Most updates hit the touch
+    if (!levels_.empty() && levels_.back().price == price) {
+        return levels_.back().level;
+    }
+
+    auto it = lowerBound(price);
+    if (it != levels_.end() && it->price == price) {
+        return it->level;
+    }
+
+    PriceLevel* level = level_pool_.create(PriceLevel{price, 0, 0, nullptr, nullptr});
+    levels_.insert(it, Entry{price, level});
+    return level;
+}
+
+void BookSide::sortedRemove(PriceLevel* level) {
+    auto it = lowerBound(level->price);
+    if (it != levels_.end() && it->level == level) {
+        levels_.erase(it);
+        level_pool_.destroy(level);
+    }
+}
+
+PriceLevel* BookSide::ladderFindOrCreate(int64_t price) {
+    const int64_t rank = rankOf(price);
+    if (window_levels_ == 0 || rank >= base_ + static_cast<int64_t>(kLadderTicks)) {
+        // First level, or a price better than anything in the window
+        recentre(rank);
+    } else if (rank < base_) {
+        // Behind the window: fine if it is far from the touch, otherwise
+        // the window has drifted and is moved back over the best level
+        const int64_t best = base_ + static_cast<int64_t>(best_slot_);
+        if (best - rank >= static_cast<int64_t>(kLadderTicks / 2)) {
+            return sortedFindOrCreate(price);
+        }
+        recentre(best);
+    }
+
+    const size_t slot = static_cast<size_t>(rank - base_);
+    if (!occupied(slot)) {
+        setSlot(slot, level_pool_.create(PriceLevel{price, 0, 0, nullptr, nullptr}));
+    }
+    return slots_[slot];
+}
+
+void BookSide::ladderRemove(PriceLevel* level) {
+    const int64_t offset = rankOf(level->price) - base_;
+    if (offset < 0 || offset >= static_cast<int64_t>(kLadderTicks) ||
+        !occupied(static_cast<size_t>(offset)) || slots_[offset] != level) {
+        sortedRemove(level);
+        return;
+    }
+
+    clearSlot(static_cast<size_t>(offset));
+    level_pool_.destroy(level);
+    // Keep the best level in the window
+    if (window_levels_ == 0 && !levels_.empty()) {
+        recentre(rankOf(levels_.back().price));
+    }
+}
+
+void BookSide::setSlot(size_t slot, PriceLevel* level) {
+    slots_[slot] = level;
+    bits_[slot / 64] |= uint64_t(1) << (slot % 64);
+    summary_ |= uint64_t(1) << (slot / 64);
+    if (window_levels_++ == 0 || slot > best_slot_) {
+        best_slot_ = slot;
+    }
+}
+
+void BookSide::clearSlot(size_t slot) {
+    bits_[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+    if (bits_[slot / 64] == 0) {
+        summary_ &= ~(uint64_t(1) << (slot / 64));
+    }
+    if (--window_levels_ > 0 && slot == best_slot_) {
+        best_slot_ = scanBest();
+    }
+}
+
+void BookSide::recentre(int64_t rank) {
+    // Every window level ranks above every array level, so appending them
+    // in rank order keeps the array sorted
+    for (uint64_t summary = summary_; summary != 0; summary &= summary - 1) {
+        const size_t word = static_cast<size_t>(__builtin_ctzll(summary));
+        for (uint64_t bits = bits_[word]; bits != 0; bits &= bits - 1) {
+            const size_t slot = word * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+            levels_.push_back(Entry{slots_[slot]->price, slots_[slot]});
+        }
+        bits_[word] = 0;
+    }
+    summary_ = 0;
+    window_levels_ = 0;
+
+    base_ = rank - static_cast<int64_t>(kLadderTicks / 2);
+    while (!levels_.empty() && rankOf(levels_.back().price) >= base_) {
+        setSlot(static_cast<size_t>(rankOf(levels_.back().price) - base_), levels_.back().level);
+        levels_.pop_back();
+    }
+}
+
+void BookSide::clear() {
+    // Levels are trivially destructible: hand the whole pool back rather
+    // than destroying them one by one. Slots are only read where their
+    // bit is set, so the window empties with its (at most 64) bitmap words.
+    level_pool_.reset();
+    levels_.clear();
+    for (uint64_t summary = summary_; summary != 0; summary &= summary - 1) {
+        bits_[__builtin_ctzll(summary)] = 0;
+    }
+    summary_ = 0;
+    window_levels_ = 0;
+}
+
+MBOBook::MBOBook(size_t max_orders, BookLayout layout)
+    : bids_(true, kDefaultMaxLevels, layout), asks_(false, kDefaultMaxLevels, layout),
+      order_pool_(max_orders), orders_(max_orders) {
+}
+
+MBOBook::~MBOBook() {
+    clear();
+}
+
+bool MBOBook::add(uint64_t order_id, bool is_buy, int64_t price, uint32_t qty, uint64_t timestamp) {
+    Order* order = order_pool_.create(Order{order_id, price, timestamp, qty, is_buy, nullptr, nullptr, nullptr});
+    if (!orders_.insert(order_id, order_pool_.handleOf(order))) {
+        order_pool_.destroy(order);
+        return false;
+    }
+    link(order);
+    return true;
+}
+
+bool MBOBook::cancel(uint64_t order_id, uint32_t qty) {
+    const size_t pos = orders_.find(order_id);
+    if (pos == OrderIndex::npos) {
+        return false;
+    }
+
+    Order* order = order_pool_.at(orders_.handleAt(pos));
+    if (qty == 0 || qty >= order->qty) {
+        unlink(order);
+        orders_.eraseAt(pos);
+        order_pool_.destroy(order);
+        return true;
+    }
+
+    // Partial cancel keeps queue position
+    order->qty -= qty;
+    order->level->total_qty -= qty;
+    return true;
+}
+
+bool MBOBook::modify(uint64_t order_id, int64_t price, uint32_t qty, uint64_t timestamp) {
+    const size_t pos = orders_.find(order_id);
+    if (pos == OrderIndex::npos) {
+        return false;
+    }
+
+    Order* order = order_pool_.at(orders_.handleAt(pos));
+    if (price == order->price) {
+        PriceLevel* level = order->level;
+        if (qty > order->qty) {
+            // Size up loses priority: back of the same queue, level kept
+            moveToBack(order);
+            order->timestamp = timestamp;
+        }
+        // Size down (or no change) keeps its place in the queue
+        level->total_qty = level->total_qty - order->qty + qty;
+        order->qty = qty;
+        return true;
+    }
+
+    unlink(order);
+    order->price = price;
+    order->qty = qty;
+    order->timestamp = timestamp;
+    link(order);
+    return true;
+}
+
+bool MBOBook::fill(uint64_t order_id, uint32_t qty) {
+    const size_t pos = orders_.find(order_id);
+    if (pos == OrderIndex::npos) {
+        return false;
+    }
+
+    Order* order = order_pool_.at(orders_.handleAt(pos));
+    if (qty >= order->qty) {
+        unlink(order);
+        orders_.eraseAt(pos);
+        order_pool_.destroy(order);
+        return true;
+    }
+
+    order->qty -= qty;
+    order->level->total_qty -= qty;
+    return true;
+}
+
+const Order* MBOBook::find(uint64_t order_id) const {
+    const size_t pos = orders_.find(order_id);
+    return pos != OrderIndex::npos ? order_pool_.at(orders_.handleAt(pos)) : nullptr;
+}
+
+void MBOBook::depth(size_t n, std::vector<BookLevel>& bids, std::vector<BookLevel>& asks) const {
+    bids.clear();
+    asks.clear();
+    auto aggregate = [](std::vector<BookLevel>& out) {
+        return [&out](const PriceLevel& level) {
+            out.push_back(BookLevel{level.price, level.total_qty, level.order_count});
+        };
+    };
+    bids_.forEachLevel(aggregate(bids), n);
+    asks_.forEachLevel(aggregate(asks), n);
+}
+
+void MBOBook::clear() {
+    // Orders are trivially destructible and live only in the pool, and
+    // the index empties by starting a new epoch
+    order_pool_.reset();
+    orders_.clear();
+    bids_.clear();
+    asks_.clear();
+}
+
+void MBOBook::link(Order* order) {
+    PriceLevel* level = sideOf(order->is_buy).findOrCreate(order->price);
+    order->level = level;
+    order->next = nullptr;
+    order->prev = level->tail;
+    if (level->tail) {
+        level->tail->next = order;
+    } else {
+        level->head = order;
+    }
+    level->tail = order;
+    level->total_qty += order->qty;
+    level->order_count++;
+}
+
+void MBOBook::moveToBack(Order* order) {
+    PriceLevel* level = order->level;
+    if (level->tail == order) {
+        return;
+    }
+    // Not the tail, so order->next is set
+    if (order->prev) {
+        order->prev->next = order->next;
+    } else {
+        level->head = order->next;
+    }
+    order->next->prev = order->prev;
+    order->prev = level->tail;
+    order->next = nullptr;
+    level->tail->next = order;
+    level->tail = order;
+}
+
+void MBOBook::unlink(Order* order) {
+    PriceLevel* level = order->level;
+    if (order->prev) {
+        order->prev->next = order->next;
+    } else {
+        level->head = order->next;
+    }
+    if (order->next) {
+        order->next->prev = order->prev;
+    } else {
+        level->tail = order->prev;
+    }
+    level->total_qty -= order->qty;
+    level->order_count--;
+    order->prev = order->next = nullptr;
+    order->level = nullptr;
+
+    if (level->order_count == 0) {
+        sideOf(order->is_buy).removeLevel(level);
+    }
+}
@@ -1,75 +1,79 @@
 #include "MBOSubscriber.hpp"
 #include <fastdds/dds/domain/DomainParticipantFactory.hpp>
-#include <fastdds/dds/topic/TopicDataType.hpp>
+#include <fastdds/dds/core/LoanableSequence.hpp>
+#include <fastdds/dds/subscriber/SampleInfo.hpp>
+#include "MBOBatchType.hpp"
+#include "MBORecoveryType.hpp"
+#include "MBOWireType.hpp"
+#include "Timestamp.hpp"
+#include <algorithm>
 #include <iostream>
-#include <sstream>
-#include <iomanip>
+#include <atomic>
 #include <thread>
 #include <chrono>
 
-// Simple string type for FastDDS (same as publisher)
-class StringType : public eprosima::fastdds::dds::TopicDataType {
-public:
-    StringType() {
-        setName("StringType");
-        m_typeSize = 4096;
-        m_isGetKeyDefined = false;
-    }
-
-    bool serialize(void* data, eprosima::fastrtps::rtps::SerializedPayload_t* payload) override {
-        std::string* str = static_cast<std::string*>(data);
-        payload->length = static_cast<uint32_t>(str->size());
-        memcpy(payload->data, str->data(), str->size());
-        return true;
-    }
-
-    bool deserialize(eprosima::fastrtps::rtps::SerializedPayload_t* payload, void* data) override {
-        std::string* str = static_cast<std::string*>(data);
-        str->assign(reinterpret_cast<char*>(payload->data), payload->length);
-        return true;
-    }
-
-    std::function<uint32_t()> getSerializedSizeProvider(void* data) override {
-        return [data]() -> uint32_t {
-            return static_cast<uint32_t>(static_cast<std::string*>(data)->size());
-        };
-    }
+namespace {
 
-    void* createData() override {
-        return new std::string();
-    }
+std::atomic<bool> g_stop_requested{false};
 
-    void deleteData(void* data) override {
-        delete static_cast<std::string*>(data);
-    }
+// How often run() forwards recovery requests; well under the gap timeouts
+constexpr auto kRecoveryPoll = std::chrono::milliseconds(1);
 
-    bool getKey(void*, eprosima::fastrtps::rtps::InstanceHandle_t*, bool) override {
-        return false;
-    }
-};
+} // namespace
 
-MBOSubscriber::MBOSubscriber()
-    : participant(nullptr), subscriber(nullptr), topic(nullptr), reader(nullptr),
-      matched_publishers(0), samples_received(0) 
+MBOSubscriber::MBOSubscriber(const SubscriberConfig& config)
+    : participant(nullptr), subscriber(nullptr), topic(nullptr), filtered_topic(nullptr), reader(nullptr),
+      recovery_publisher(nullptr), recovery_topic(nullptr), recovery_writer(nullptr), recovery_requests_sent(0),
+      matched_publishers(0), config_(config), dispatch_stats_(&local_dispatch_stats_)
 {
-    type.reset(new StringType());
-    orderbook_mgr_ = std::make_unique<OrderBookManager>();
-    // Initialize JSON file output
-    orderbook_mgr_->initializeJSONFile("orderbook_snapshots.json");
+    recovery_type.reset(new MBORecoveryType());
+    if (config_.batched) {
+        type.reset(new MBOBatchType());
+    } else {
+        type.reset(new MBOWireType());
+    }
+    registry_ = std::make_unique<BookRegistry>(config_.registry);
 }
 
 MBOSubscriber::~MBOSubscriber() {
+    // Stop the reader first so no listener callback races the shutdown
     if (reader) subscriber->delete_datareader(reader);
+    if (filtered_topic) participant->delete_contentfilteredtopic(filtered_topic);
     if (topic) participant->delete_topic(topic);
     if (subscriber) participant->delete_subscriber(subscriber);
+    if (recovery_writer) recovery_publisher->delete_datawriter(recovery_writer);
+    if (recovery_topic) participant->delete_topic(recovery_topic);
+    if (recovery_publisher) participant->delete_publisher(recovery_publisher);
     if (participant) {
+        participant->unregister_content_filter_factory(kInstrumentFilterClass);
         eprosima::fastdds::dds::DomainParticipantFactory::get_instance()->delete_participant(participant);
     }
+    // Apply what is still queued, then write out the last snapshots
+    registry_->stop();
+    printStats(std::cout);
+    if (recovery_requests_sent > 0) {
+        std::cout << "Recovery requests sent: " << recovery_requests_sent << std::endl;
+    }
 }
 
 bool MBOSubscriber::init() {
     using namespace eprosima::fastdds::dds;
 
+    // Snapshot/journal outputs and the shard threads must be up before
+    // samples arrive. Serialisation and file I/O never happen in the
+    // listener callback.
+    if (!config_.stats_name.empty()) {
+        // Not fatal: without the segment the counters stay in process
+        if (stats_segment_.create(config_.stats_name, StatsService::Subscriber, registry_->shardCount())) {
+            dispatch_stats_ = &stats_segment_.dispatch();
+            registry_->setStats(stats_segment_);
+            std::cout << "Live stats in " << StatsSegment::path(config_.stats_name) << std::endl;
+        }
+    }
+    if (!registry_->init()) {
+        return false;
+    }
+
     DomainParticipantQos pqos;
     pqos.name("MBOSubscriber_Participant");
     
@@ -82,6 +86,11 @@ bool MBOSubscriber::init() {
     // Register the type
     type.register_type(participant);
 
+    if (participant->register_content_filter_factory(kInstrumentFilterClass, &filter_factory) != ReturnCode_t::RETCODE_OK) {
+        std::cerr << "Failed to register instrument filter" << std::endl;
+        return false;
+    }
+
     subscriber = participant->create_subscriber(SUBSCRIBER_QOS_DEFAULT, nullptr);
     if (!subscriber) {
         std::cerr << "Failed to create subscriber" << std::endl;
@@ -89,16 +98,55 @@ bool MBOSubscriber::init() {
     }
 
     TopicQos tqos = TOPIC_QOS_DEFAULT;
-    topic = participant->create_topic("MBOTopic", type.get_type_name(), tqos);
+    const char* topic_name = config_.batched ? kBatchTopicName : "MBOTopic";
+    topic = participant->create_topic(topic_name, type.get_type_name(), tqos);
     if (!topic) {
         std::cerr << "Failed to create topic" << std::endl;
         return false;
     }
 
+    // Only this process's instruments: the publisher evaluates the filter
+    // before sending, so the rest never cross the network or get parsed
+    TopicDescription* source = topic;
+    if (!config_.instruments.empty()) {
+        filtered_topic = participant->create_contentfilteredtopic(
+            std::string(topic_name) + "_instruments", topic, config_.instruments, {}, kInstrumentFilterClass);
+        if (!filtered_topic) {
+            std::cerr << "Failed to create instrument filter: " << config_.instruments << std::endl;
+            return false;
+        }
+        source = filtered_topic;
+    }
+
     DataReaderQos rqos = DATAREADER_QOS_DEFAULT;
     rqos.reliability().kind = RELIABLE_RELIABILITY_QOS;
-    
-    reader = subscriber->create_datareader(topic, rqos, this);
+    // Read loaned samples straight out of the publisher's shared memory
+    rqos.data_sharing().automatic();
+    // One instance per instrument (0 = unlimited)
+    rqos.resource_limits().max_instances = 0;
+
+    // Gaps are recovered by asking the publisher to resend; this writer
+    // must be matched before the first sample can need it
+    recovery_type.register_type(participant);
+    recovery_publisher = participant->create_publisher(PUBLISHER_QOS_DEFAULT, nullptr);
+    if (!recovery_publisher) {
+        std::cerr << "Failed to create recovery publisher" << std::endl;
+        return false;
+    }
+    recovery_topic = participant->create_topic(kRecoveryTopicName, recovery_type.get_type_name(), TOPIC_QOS_DEFAULT);
+    if (!recovery_topic) {
+        std::cerr << "Failed to create recovery topic" << std::endl;
+        return false;
+    }
+    DataWriterQos wqos = DATAWRITER_QOS_DEFAULT;
+    wqos.reliability().kind = RELIABLE_RELIABILITY_QOS;
+    recovery_writer = recovery_publisher->create_datawriter(recovery_topic, wqos, nullptr);
+    if (!recovery_writer) {
+        std::cerr << "Failed to create recovery datawriter" << std::endl;
+        return false;
+    }
+
+    reader = subscriber->create_datareader(source, rqos, this);
     if (!reader) {
         std::cerr << "Failed to create datareader" << std::endl;
         return false;
@@ -122,78 +170,109 @@ void MBOSubscriber::on_subscription_matched(
 }
 
 void MBOSubscriber::on_data_available(eprosima::fastdds::dds::DataReader* reader) {
-    eprosima::fastdds::dds::SampleInfo info;
-    std::string message;
-    
-    while (reader->take_next_sample(&message, &info) == ReturnCode_t::RETCODE_OK) {
-        if (info.valid_data) {
-            samples_received++;
-            
-            // Parse the CSV string back to MBOParsed
-            MBOParsed record = parseCSVString(message);
-            
-            // Process through OrderBook (prints JSON snapshot)
-            orderbook_mgr_->processMessage(record);
+    if (config_.batched) {
+        takeBatches(reader);
+        return;
+    }
+
+    eprosima::fastdds::dds::LoanableSequence<MBOWire> samples;
+    eprosima::fastdds::dds::SampleInfoSeq infos;
+
+    while (reader->take(samples, infos) == ReturnCode_t::RETCODE_OK) {
+        const uint64_t now_ns = monotonicNowNs();
+        for (eprosima::fastdds::dds::LoanableCollection::size_type i = 0; i < infos.length(); ++i) {
+            if (infos[i].valid_data) {
+                dispatch_stats_->samples_in.add();
+                recordReceived(samples[i], now_ns);
+
+                // Only copy the raw sample to its instrument's shard; the
+                // shard thread decodes and applies it. FastDDS doesn't
+                // overlap listener calls for one reader, so this is each
+                // ring's single producer.
+                if (!registry_->dispatch(samples[i])) {
+                    dispatch_stats_->dropped.add();
+                }
+            }
         }
+        reader->return_loan(samples, infos);
     }
 }
 
-MBOParsed MBOSubscriber::parseCSVString(const std::string& csv_line) {
-    MBOParsed record{};
-    std::stringstream ss(csv_line);
-    std::string field;
-    std::vector<std::string> fields;
-    
-    while (std::getline(ss, field, ',')) {
-        fields.push_back(field);
+void MBOSubscriber::takeBatches(eprosima::fastdds::dds::DataReader* reader) {
+    eprosima::fastdds::dds::LoanableSequence<MBOBatch> samples;
+    eprosima::fastdds::dds::SampleInfoSeq infos;
+
+    while (reader->take(samples, infos) == ReturnCode_t::RETCODE_OK) {
+        const uint64_t now_ns = monotonicNowNs();
+        for (eprosima::fastdds::dds::LoanableCollection::size_type i = 0; i < infos.length(); ++i) {
+            if (infos[i].valid_data) {
+                // Data-shared samples skip deserialize(), so clamp here too
+                const MBOBatch& batch = samples[i];
+                const uint32_t count = std::min<uint32_t>(batch.header.count, kMaxBatchRecords);
+                // The header must describe the records it carries; each
+                // record is still sequenced on its own, so apply them anyway
+                if (batch.header.count > kMaxBatchRecords ||
+                    (count > 0 && (batch.records[0].feed_sequence != batch.header.first_sequence ||
+                                   batch.records[0].instrument_id != batch.header.instrument_id))) {
+                    dispatch_stats_->malformed.add();
+                }
+                dispatch_stats_->samples_in.add(count);
+                for (uint32_t j = 0; j < count; ++j) {
+                    recordReceived(batch.records[j], now_ns);
+                    if (!registry_->dispatch(batch.records[j])) {
+                        dispatch_stats_->dropped.add();
+                    }
+                }
+            }
+        }
+        reader->return_loan(samples, infos);
     }
-    
-    if (fields.size() >= 15) {
-        record.ts_event_str = fields[0];
-        record.rtype = static_cast<uint8_t>(std::stoi(fields[1]));
-        record.publisher_id = static_cast<uint16_t>(std::stoi(fields[2]));
-        record.instrument_id = static_cast<uint32_t>(std::stoul(fields[3]));
-        record.action = fields[4][0];
-        record.side = fields[5][0];
-        record.price = std::stod(fields[6]);
-        record.size = static_cast<uint32_t>(std::stoul(fields[7]));
-        record.channel_id = static_cast<uint8_t>(std::stoi(fields[8]));
-        record.order_id = std::stoull(fields[9]);
-        record.flags = static_cast<uint8_t>(std::stoi(fields[10]));
-        record.ts_in_delta = std::stoi(fields[11]);
-        record.sequence = static_cast<uint32_t>(std::stoul(fields[12]));
-        record.symbol = fields[13];
-        record.datetime = fields[14];
+}
+
+void MBOSubscriber::recordReceived(const MBOWire& sample, uint64_t now_ns) {
+    if (sample.ts_send != 0) {
+        // A stamp from another host's clock can be ahead of ours
+        dispatch_stats_->received.record(now_ns > sample.ts_send ? now_ns - sample.ts_send : 0);
     }
-    
-    return record;
 }
 
-void MBOSubscriber::printRecord(const MBOParsed& r) {
-    std::cout << std::fixed << std::setprecision(2)
-              << "ts_event=" << r.ts_event_str
-              << " rtype=" << int(r.rtype)
-              << " publisher_id=" << r.publisher_id
-              << " instrument_id=" << r.instrument_id
-              << " action=" << r.action
-              << " side=" << r.side
-              << " price=" << r.price
-              << " size=" << r.size
-              << " channel_id=" << int(r.channel_id)
-              << " order_id=" << r.order_id
-              << " flags=" << int(r.flags)
-              << " ts_in_delta=" << r.ts_in_delta
-              << " sequence=" << r.sequence
-              << " symbol=" << r.symbol
-              << " datetime=" << r.datetime
-              << std::endl;
+void MBOSubscriber::sendRecoveryRequests() {
+    MBORecoveryRequest request;
+    while (registry_->takeRecoveryRequest(request)) {
+        if (recovery_writer->write(&request) == ReturnCode_t::RETCODE_OK) {
+            ++recovery_requests_sent;
+        }
+    }
+}
+
+void MBOSubscriber::printStats(std::ostream& out) const {
+    registry_->printStats(out);
+    if (dispatch_stats_->received.count() > 0) {
+        LatencyHistogram latency;
+        dispatch_stats_->received.snapshot(latency);
+        out << "Received since send: ";
+        printPercentiles(out, latency);
+        out << std::endl;
+    }
+}
+
+void MBOSubscriber::requestStop() {
+    g_stop_requested.store(true, std::memory_order_relaxed);
 }
 
 void MBOSubscriber::run() {
     std::cout << "Waiting for samples... Press Ctrl+C to exit." << std::endl;
     
-    // Keep running until user stops
-    while (true) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+    auto last_stats = std::chrono::steady_clock::now();
+    while (!g_stop_requested.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_for(kRecoveryPoll);
+        sendRecoveryRequests();
+        
+        if (config_.stats_interval_s > 0 &&
+            std::chrono::steady_clock::now() - last_stats >= std::chrono::seconds(config_.stats_interval_s)) {
+            printStats(std::cerr);
+            last_stats = std::chrono::steady_clock::now();
+        }
     }
+    std::cout << "Shutting down" << std::endl;
 }
\ No newline at end of file
@@ -1,35 +1,65 @@
 #include "OrderBookManager.hpp"
-#include <iostream>
-#include <iomanip>
-#include <sstream>
-#include <vector>
-#include <set>
-#include <algorithm>
+#include <cstring>
 
-using namespace liquibook;
-
-OrderBookManager::OrderBookManager() : current_sequence_(0) {
-    // Create Liquibook depth order book
-    orderbook_ = new book::DepthOrderBook<Order*>();
+OrderBookManager::OrderBookManager(size_t max_orders, size_t max_pending_cancels, uint32_t instrument_id,
+                                   BookLayout layout)
+    : book_(max_orders, layout), off_tick_prices_(0),
+      pending_cancels_(max_pending_cancels),
+      instrument_id_(instrument_id), current_sequence_(0), feed_session_(0), last_trade_price_(0), last_trade_qty_(0),
+      traded_volume_(0), fills_update_book_(false),
+      messages_since_snapshot_(0), last_snapshot_ts_(0), last_top_{},
+      snapshot_writer_(nullptr), journal_(nullptr),
+      journal_snapshot_every_(kDefaultJournalSnapshotEvery), messages_since_journal_snapshot_(0) {
 }
 
-OrderBookManager::~OrderBookManager() {
-    // Clean up all orders
-    for (auto& pair : order_map_) {
-        delete pair.second;
-    }
-    order_map_.clear();
+void OrderBookManager::processMessage(const MBOParsed& msg) {
+    applyMessage(msg);
     
-    // Close JSON file if open
-    if (json_file_.is_open()) {
-        json_file_.close();
+    if (journal_) {
+        journal_->appendDelta(msg, feed_session_);
+        if (++messages_since_journal_snapshot_ >= journal_snapshot_every_) {
+            messages_since_journal_snapshot_ = 0;
+            writeJournalSnapshot(msg);
+        }
     }
     
-    delete orderbook_;
+    if (snapshotDue(msg)) {
+        captureSnapshot();
+    }
 }
 
-void OrderBookManager::processMessage(const MBOParsed& msg) {
-    current_symbol_ = msg.symbol;
+bool OrderBookManager::snapshotDue(const MBOParsed& msg) {
+    switch (snapshot_policy_.mode) {
+        case SnapshotMode::Off:
+            return false;
+        case SnapshotMode::EveryN:
+            if (++messages_since_snapshot_ < snapshot_policy_.every_n) {
+                return false;
+            }
+            messages_since_snapshot_ = 0;
+            return true;
+        case SnapshotMode::Interval:
+            if (msg.ts_event - last_snapshot_ts_ < snapshot_policy_.interval_us * 1000) {
+                return false;
+            }
+            last_snapshot_ts_ = msg.ts_event;
+            return true;
+        case SnapshotMode::OnTopChange: {
+            const TopOfBook top = getTopOfBook();
+            if (top.bid.price == last_top_.bid.price && top.bid.qty == last_top_.bid.qty &&
+                top.ask.price == last_top_.ask.price && top.ask.qty == last_top_.ask.qty) {
+                return false;
+            }
+            last_top_ = top;
+            return true;
+        }
+    }
+    return false;
+}
+
+void OrderBookManager::applyMessage(const MBOParsed& msg) {
+    instrument_id_ = msg.instrument_id;
+    current_symbol_.assign(msg.symbol, strnlen(msg.symbol, kSymbolLen));
     current_sequence_ = msg.sequence;
     
     switch (msg.action) {
@@ -40,267 +70,166 @@ void OrderBookManager::processMessage(const MBOParsed& msg) {
             handleCancel(msg);
             break;
         case 'M':
-        case 'R':
             handleModify(msg);
             break;
+        case 'R':
+            handleClear();
+            break;
         case 'T':
             handleTrade(msg);
             break;
+        case 'F':
+            handleFill(msg);
+            break;
         default:
             break;
     }
-    
-    // Print JSON after every message
-    printBookStateJSON();
+}
+
+int64_t OrderBookManager::ticksOf(const MBOParsed& msg) {
+    bool off_grid;
+    const int64_t ticks = tick_.toTicks(msg.price, off_grid);
+    off_tick_prices_ += off_grid;
+    return ticks;
 }
 
 void OrderBookManager::handleAdd(const MBOParsed& msg) {
-    // Check for duplicate
-    if (order_map_.find(msg.order_id) != order_map_.end()) {
+    // Duplicate adds are ignored by the book
+    if (!book_.add(msg.order_id, convertSideToBool(msg.side), ticksOf(msg), msg.size, msg.ts_event)) {
         return;
     }
     
-    // Create Liquibook order with metadata
-    bool is_buy = convertSideToBool(msg.side);
-    uint64_t price = convertPrice(msg.price);
-    uint32_t qty = msg.size;
-    
-    Order* order = new Order(is_buy, price, qty, msg.order_id, msg.datetime);
-    
-    // Add to Liquibook with no conditions
-    orderbook_->add(order, book::oc_no_conditions);
-    
-    // Store in map
-    order_map_[msg.order_id] = order;
-    
-    // Store metadata
-    order_metadata_[msg.order_id] = {
-        msg.order_id,
-        msg.datetime,
-        msg.price,
-        msg.size
-    };
-    
     // Check if there was a pending cancel
-    auto pending = pending_cancels_.find(msg.order_id);
-    if (pending != pending_cancels_.end()) {
-        handleCancel(pending->second);
-        pending_cancels_.erase(pending);
+    PendingCancel cancel;
+    if (pending_cancels_.take(msg.order_id, msg.sequence, msg.ts_event, cancel)) {
+        book_.cancel(cancel.order_id, cancel.qty);
     }
 }
 
 void OrderBookManager::handleCancel(const MBOParsed& msg) {
-    Order* order = findOrder(msg.order_id);
-    
-    if (!order) {
+    if (!book_.cancel(msg.order_id, msg.size)) {
         // Order not found - might be out of order message
-        pending_cancels_[msg.order_id] = msg;
-        return;
+        pending_cancels_.insert(PendingCancel{msg.order_id, msg.ts_event, msg.sequence, msg.size});
     }
-    
-    // Cancel in Liquibook
-    orderbook_->cancel(order);
-    
-    // Remove from maps
-    order_map_.erase(msg.order_id);
-    order_metadata_.erase(msg.order_id);
-    
-    // Clean up memory
-    delete order;
 }
 
 void OrderBookManager::handleModify(const MBOParsed& msg) {
-    Order* order = findOrder(msg.order_id);
-    
-    if (!order) {
+    if (book_.modify(msg.order_id, ticksOf(msg), msg.size, msg.ts_event)) {
         return;
     }
     
-    // Liquibook doesn't have native modify - do cancel + add
-    bool is_buy = order->is_buy();
-    
-    // Cancel old order
-    orderbook_->cancel(order);
-    order_map_.erase(msg.order_id);
-    delete order;
-    
-    // Add new order with modified parameters
-    uint64_t new_price = convertPrice(msg.price);
-    uint32_t new_qty = msg.size;
-    
-    Order* new_order = new Order(is_buy, new_price, new_qty, msg.order_id, msg.datetime);
-    orderbook_->add(new_order, book::oc_no_conditions);
-    order_map_[msg.order_id] = new_order;
-    
-    // Update metadata
-    order_metadata_[msg.order_id] = {
-        msg.order_id,
-        msg.datetime,
-        msg.price,
-        msg.size
-    };
+    // A modify for an order we never saw (feed joined mid-session)
+    // carries the full order, so it enters the book like an add
+    handleAdd(msg);
+}
+
+void OrderBookManager::handleClear() {
+    // The venue starts the book over (session start, recovery); cancels
+    // still waiting for an order from before the clear won't get one
+    book_.clear();
+    pending_cancels_.clear();
 }
 
 void OrderBookManager::handleTrade(const MBOParsed& msg) {
-    Order* order = findOrder(msg.order_id);
-    
-    if (!order) {
-        return;
-    }
+    // Trade prints don't rest in the book; the affected orders are
+    // updated by the fills and cancels/modifies that follow
+    last_trade_price_ = msg.price;
+    last_trade_qty_ = msg.size;
+    traded_volume_ += msg.size;
 }
 
-Order* OrderBookManager::findOrder(uint64_t order_id) {
-    auto it = order_map_.find(order_id);
-    if (it != order_map_.end()) {
-        return it->second;
+void OrderBookManager::handleFill(const MBOParsed& msg) {
+    if (fills_update_book_) {
+        book_.fill(msg.order_id, msg.size);
     }
-    return nullptr;
 }
 
 bool OrderBookManager::convertSideToBool(char side) {
     return (side == 'B' || side == 'b');
 }
 
-uint64_t OrderBookManager::convertPrice(double price) {
-    // Scale price to avoid floating point (e.g., $123.45 -> 12345)
-    // Assuming 2 decimal places for stocks
-    return static_cast<uint64_t>(price * 100.0);
-}
-
-void OrderBookManager::initializeJSONFile(const std::string& filename) {
-    if (json_file_.is_open()) {
-        json_file_.close();
+void OrderBookManager::captureSnapshot() {
+    if (!snapshot_writer_) {
+        return;
     }
-    json_file_.open(filename, std::ios::out | std::ios::trunc);
-    if (!json_file_.is_open()) {
-        std::cerr << "Error opening JSON file: " << filename << std::endl;
+    BookView* view = snapshot_writer_->acquire();
+    if (!view) {
+        return;
     }
+    view->instrument_id = instrument_id_;
+    view->symbol = current_symbol_;
+    view->sequence = current_sequence_;
+    captureBook(book_, tick_, *view);
+    snapshot_writer_->publish(view);
 }
 
-void OrderBookManager::printBookStateJSON() {
-    const book::DepthOrderBook<Order*>* depth_book = 
-        dynamic_cast<const book::DepthOrderBook<Order*>*>(orderbook_);
-    
-    if (!depth_book) {
-        return;
-    }
+namespace {
 
-    std::stringstream json_output;
-    json_output << "{\n";
-    json_output << "  \"symbol\": \"" << current_symbol_ << "\",\n";
-    json_output << "  \"sequence\": " << current_sequence_ << ",\n";
-    json_output << "  \"bids\": [\n";
-    
-    // Collect all buy orders with their full metadata
-    // Structure: price -> vector of (order_id, timestamp, quantity)
-    std::map<double, std::vector<std::tuple<uint64_t, std::string, uint32_t>>, std::greater<double>> buy_by_price;
-    
-    for (const auto& pair : order_map_) {
-        Order* order = pair.second;
-        if (order && order->is_buy()) {
-            double price = order->price() / 100.0;
-            uint64_t order_id = order->get_order_id();
-            const std::string& timestamp = order->get_timestamp();
-            uint32_t qty = order->order_qty();
-            
-            // Validate price
-            if (order->price() > 0 && price < 1000000.0) {
-                buy_by_price[price].push_back({order_id, timestamp, qty});
-            }
-        }
-    }
-    
-    // Print buy orders, grouped by price (descending - highest first)
-    size_t price_idx = 0;
-    for (const auto& price_group : buy_by_price) {
-        double price = price_group.first;
-        const auto& orders_at_price = price_group.second;
-        
-        // Print each individual order at this price level
-        for (size_t order_idx = 0; order_idx < orders_at_price.size(); ++order_idx) {
-            uint64_t order_id = std::get<0>(orders_at_price[order_idx]);
-            const std::string& timestamp = std::get<1>(orders_at_price[order_idx]);
-            uint32_t qty = std::get<2>(orders_at_price[order_idx]);
-            
-            json_output << "    {\n";
-            json_output << "      \"order_id\": " << order_id << ",\n";
-            json_output << "      \"timestamp\": \"" << timestamp << "\",\n";
-            json_output << "      \"price\": " << std::fixed << std::setprecision(2) << price << ",\n";
-            json_output << "      \"quantity\": " << qty << "\n";
-            json_output << "    }";
-            
-            // Add comma if not the last order overall
-            bool is_last_order = (price_idx == buy_by_price.size() - 1) && 
-                                 (order_idx == orders_at_price.size() - 1);
-            if (!is_last_order) {
-                json_output << ",";
-            }
-            json_output << "\n";
-        }
-        price_idx++;
-    }
-    
-    json_output << "  ],\n";
-    json_output << "  \"asks\": [\n";
-    
-    // Collect all sell orders with their full metadata
-    // Structure: price -> vector of (order_id, timestamp, quantity)
-    std::map<double, std::vector<std::tuple<uint64_t, std::string, uint32_t>>, std::less<double>> sell_by_price;
-    
-    for (const auto& pair : order_map_) {
-        Order* order = pair.second;
-        if (order && !order->is_buy()) {
-            double price = order->price() / 100.0;
-            uint64_t order_id = order->get_order_id();
-            const std::string& timestamp = order->get_timestamp();
-            uint32_t qty = order->order_qty();
-            
-            // Validate price
-            if (order->price() > 0 && price < 1000000.0) {
-                sell_by_price[price].push_back({order_id, timestamp, qty});
-            }
-        }
-    }
-    
-    // Print sell orders, grouped by price (ascending - lowest first)
-    price_idx = 0;
-    for (const auto& price_group : sell_by_price) {
-        double price = price_group.first;
-        const auto& orders_at_price = price_group.second;
-        
-        // Print each individual order at this price level
-        for (size_t order_idx = 0; order_idx < orders_at_price.size(); ++order_idx) {
-            uint64_t order_id = std::get<0>(orders_at_price[order_idx]);
-            const std::string& timestamp = std::get<1>(orders_at_price[order_idx]);
-            uint32_t qty = std::get<2>(orders_at_price[order_idx]);
-            
-            json_output << "    {\n";
-            json_output << "      \"order_id\": " << order_id << ",\n";
-            json_output << "      \"timestamp\": \"" << timestamp << "\",\n";
-            json_output << "      \"price\": " << std::fixed << std::setprecision(2) << price << ",\n";
-            json_output << "      \"quantity\": " << qty << "\n";
-            json_output << "    }";
-            
-            // Add comma if not the last order overall
-            bool is_last_order = (price_idx == sell_by_price.size() - 1) && 
-                                 (order_idx == orders_at_price.size() - 1);
-            if (!is_last_order) {
-                json_output << ",";
-            }
-            json_output << "\n";
+uint32_t sideOrderCount(const BookSide& side) {
+    uint32_t count = 0;
+    side.forEachLevel([&count](const PriceLevel& level) { count += level.order_count; });
+    return count;
+}
+
+} // namespace
+
+void OrderBookManager::writeJournalSide(const BookSide& side) {
+    side.forEachLevel([this](const PriceLevel& level) {
+        for (const Order* order = level.head; order; order = order->next) {
+            journal_->appendOrder(JournalOrder{order->order_id, order->timestamp, tick_.toPrice(level.price), order->qty, 0});
         }
-        price_idx++;
-    }
-    
-    json_output << "  ]\n";
-    json_output << "}\n";
-    
-    // Print to console
-    std::cout << json_output.str();
-    
-    // Write to file if open
-    if (json_file_.is_open()) {
-        json_file_ << json_output.str();
-        json_file_.flush();
+    });
+}
+
+void OrderBookManager::writeJournalSnapshot(const MBOParsed& msg) {
+    JournalSnapshotHeader snapshot{};
+    snapshot.ts_event = msg.ts_event;
+    snapshot.last_trade_price = last_trade_price_;
+    snapshot.traded_volume = traded_volume_;
+    snapshot.sequence = msg.sequence;
+    snapshot.last_trade_qty = last_trade_qty_;
+    snapshot.bid_orders = sideOrderCount(book_.bids());
+    snapshot.ask_orders = sideOrderCount(book_.asks());
+    snapshot.pending_cancels = static_cast<uint32_t>(pending_cancels_.size());
+    snapshot.instrument_id = instrument_id_;
+    snapshot.feed_session = feed_session_;
+    std::memcpy(snapshot.symbol, msg.symbol, kSymbolLen);
+    
+    journal_->beginSnapshot(snapshot);
+    writeJournalSide(book_.bids());
+    writeJournalSide(book_.asks());
+    pending_cancels_.forEach([this](const PendingCancel& cancel) { journal_->appendPendingCancel(cancel); });
+}
+
+void OrderBookManager::reset() {
+    book_.clear();
+    pending_cancels_.clear();
+    current_symbol_.clear();
+    current_sequence_ = 0;
+    last_trade_price_ = 0;
+    last_trade_qty_ = 0;
+    traded_volume_ = 0;
+    // Journal a snapshot with the next message, so readers don't carry
+    // the old book into what follows
+    messages_since_journal_snapshot_ = journal_snapshot_every_ - 1;
+}
+
+void OrderBookManager::restoreSnapshot(const JournalSnapshotHeader& snapshot, const JournalOrder* orders) {
+    reset();
+    instrument_id_ = snapshot.instrument_id;
+    current_symbol_.assign(snapshot.symbol, strnlen(snapshot.symbol, kSymbolLen));
+    current_sequence_ = snapshot.sequence;
+    feed_session_ = snapshot.feed_session;
+    last_trade_price_ = snapshot.last_trade_price;
+    last_trade_qty_ = snapshot.last_trade_qty;
+    traded_volume_ = snapshot.traded_volume;
+    
+    // Re-adding in priority order rebuilds each level's queue as it was.
+    // The journal keeps fixed-point prices.
+    const uint32_t total = snapshot.bid_orders + snapshot.ask_orders;
+    for (uint32_t i = 0; i < total; ++i) {
+        const JournalOrder& order = orders[i];
+        bool off_grid;
+        book_.add(order.order_id, i < snapshot.bid_orders, tick_.toTicks(order.price, off_grid), order.qty, order.timestamp);
     }
-}
\ No newline at end of file
+}
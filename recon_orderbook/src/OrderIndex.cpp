@@ -0,0 +1,118 @@
+#include "OrderIndex.hpp"
+
+OrderIndex::OrderIndex(size_t capacity)
+    : mask_(0), shift_(64), size_(0), max_size_(0), epoch_(1) {
+    size_t slots = 16;
+    while (slots < capacity * 2) {
+        slots <<= 1;
+    }
+    // The whole table up front, like the book's pools, so insert() never
+    // rehashes while the book stays within capacity
+    allocate(slots);
+}
+
+void OrderIndex::allocate(size_t slots) {
+    entries_.assign(slots, Entry{0, 0, 0});
+    mask_ = slots - 1;
+    shift_ = 64;
+    for (size_t size = slots; size > 1; size >>= 1) {
+        --shift_;
+    }
+    max_size_ = slots / 2;
+    epoch_ = 1;
+}
+
+bool OrderIndex::insert(uint64_t order_id, uint32_t handle) {
+    if (size_ >= max_size_) {
+        grow();
+    }
+    // Walk the run as find() would until order_id turns up or the search
+    // would end; from there on it is a plain Robin Hood placement
+    size_t pos = home(order_id);
+    uint32_t dist = 0;
+    for (;; ++dist, pos = (pos + 1) & mask_) {
+        const Entry& slot = entries_[pos];
+        if (!live(slot) || distance(slot) < dist) {
+            break;
+        }
+        if (slot.order_id == order_id) {
+            return false;
+        }
+    }
+    Entry entry{order_id, handle, 0};
+    if (!placeFrom(entry, pos, dist)) {
+        do {
+            grow();
+        } while (!placeFrom(entry, home(entry.order_id), 0));
+    }
+    ++size_;
+    return true;
+}
+
+bool OrderIndex::placeFrom(Entry& entry, size_t pos, uint32_t dist) {
+    for (;; ++dist, pos = (pos + 1) & mask_) {
+        if (dist > kMaxDistance) {
+            return false;
+        }
+        Entry& slot = entries_[pos];
+        if (!live(slot)) {
+            entry.meta = epoch_ << 8 | dist;
+            slot = entry;
+            return true;
+        }
+        if (distance(slot) < dist) {
+            // Take the slot from an entry nearer its home; carry that one on
+            const Entry displaced = slot;
+            entry.meta = epoch_ << 8 | dist;
+            slot = entry;
+            entry = displaced;
+            dist = distance(displaced);
+        }
+    }
+}
+
+void OrderIndex::grow() {
+    moving_.clear();
+    for (const Entry& entry : entries_) {
+        if (live(entry)) {
+            moving_.push_back(entry);
+        }
+    }
+    for (size_t slots = entries_.size() * 2;; slots *= 2) {
+        allocate(slots);
+        bool placed = true;
+        for (Entry entry : moving_) {
+            if (!placeFrom(entry, home(entry.order_id), 0)) {
+                placed = false;
+                break;
+            }
+        }
+        if (placed) {
+            return;
+        }
+    }
+}
+
+void OrderIndex::eraseAt(size_t pos) {
+    // Pull the rest of the run one slot nearer home
+    size_t next = (pos + 1) & mask_;
+    while (live(entries_[next]) && distance(entries_[next]) > 0) {
+        entries_[pos] = entries_[next];
+        --entries_[pos].meta;
+        pos = next;
+        next = (next + 1) & mask_;
+    }
+    entries_[pos].meta = 0;
+    --size_;
+}
+
+void OrderIndex::clear() {
+    size_ = 0;
+    if (++epoch_ > kMaxEpoch) {
+        // Epochs ran out: really empty the table, once every 16M clears
+        for (Entry& entry : entries_) {
+            entry.meta = 0;
+        }
+        epoch_ = 1;
+    }
+}
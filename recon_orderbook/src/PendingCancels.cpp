@@ -0,0 +1,168 @@
+#include "PendingCancels.hpp"
+
+namespace {
+
+size_t roundUp(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    return size;
+}
+
+} // namespace
+
+PendingCancels::PendingCancels(size_t capacity, const PendingCancelAge& age)
+    : age_(age), capacity_(capacity > 0 ? capacity : 1),
+      slots_(roundUp(capacity_) * 2, Slot{}), mask_(slots_.size() - 1), shift_(64), size_(0),
+      order_(roundUp(capacity_) * 2, Entry{}), head_(0), count_(0), next_stamp_(1),
+      inserted_(0), matched_(0), expired_(0), evicted_(0) {
+    for (size_t size = slots_.size(); size > 1; size >>= 1) {
+        --shift_;
+    }
+}
+
+size_t PendingCancels::home(uint64_t order_id) const {
+    // Fibonacci hashing: order ids are mostly sequential
+    return static_cast<size_t>((order_id * 0x9E3779B97F4A7C15ull) >> shift_);
+}
+
+size_t PendingCancels::find(uint64_t order_id) const {
+    for (size_t index = home(order_id);; index = (index + 1) & mask_) {
+        const Slot& slot = slots_[index];
+        if (slot.stamp == 0) {
+            return SIZE_MAX;
+        }
+        if (slot.cancel.order_id == order_id) {
+            return index;
+        }
+    }
+}
+
+void PendingCancels::erase(size_t index) {
+    // Pull later members of the probe run back over the hole, so lookups
+    // still stop at the first empty slot
+    for (size_t next = (index + 1) & mask_; slots_[next].stamp != 0; next = (next + 1) & mask_) {
+        const size_t ideal = home(slots_[next].cancel.order_id);
+        if (((next - ideal) & mask_) >= ((next - index) & mask_)) {
+            slots_[index] = slots_[next];
+            index = next;
+        }
+    }
+    slots_[index].stamp = 0;
+    --size_;
+}
+
+bool PendingCancels::tooOld(const PendingCancel& cancel, uint32_t sequence, uint64_t ts_event) const {
+    if (age_.max_age_sequences != 0 &&
+        static_cast<int32_t>(sequence - cancel.sequence) > static_cast<int64_t>(age_.max_age_sequences)) {
+        return true;
+    }
+    return age_.max_age_ns != 0 && ts_event > cancel.ts_event && ts_event - cancel.ts_event > age_.max_age_ns;
+}
+
+size_t PendingCancels::popOldest() {
+    const Entry entry = order_[head_];
+    head_ = (head_ + 1) & (order_.size() - 1);
+    --count_;
+    const size_t index = find(entry.order_id);
+    return index != SIZE_MAX && slots_[index].stamp == entry.stamp ? index : SIZE_MAX;
+}
+
+void PendingCancels::expire(uint32_t sequence, uint64_t ts_event) {
+    while (count_ > 0) {
+        const Entry& oldest = order_[head_];
+        const size_t index = find(oldest.order_id);
+        if (index != SIZE_MAX && slots_[index].stamp == oldest.stamp) {
+            if (!tooOld(slots_[index].cancel, sequence, ts_event)) {
+                return;
+            }
+            erase(index);
+            ++expired_;
+        }
+        head_ = (head_ + 1) & (order_.size() - 1);
+        --count_;
+    }
+}
+
+void PendingCancels::compact() {
+    // The ring is twice the capacity, so at least half of it is stale
+    const size_t ring_mask = order_.size() - 1;
+    size_t kept = 0;
+    for (size_t i = 0; i < count_; ++i) {
+        const Entry entry = order_[(head_ + i) & ring_mask];
+        const size_t index = find(entry.order_id);
+        if (index != SIZE_MAX && slots_[index].stamp == entry.stamp) {
+            order_[(head_ + kept++) & ring_mask] = entry;
+        }
+    }
+    count_ = kept;
+}
+
+void PendingCancels::insert(const PendingCancel& cancel) {
+    expire(cancel.sequence, cancel.ts_event);
+
+    if (size_ == capacity_ && find(cancel.order_id) == SIZE_MAX) {
+        // Full: the oldest cancel held makes room
+        size_t index;
+        do {
+            index = popOldest();
+        } while (index == SIZE_MAX);
+        erase(index);
+        ++evicted_;
+    }
+    if (count_ == order_.size()) {
+        compact();
+    }
+
+    const uint32_t stamp = next_stamp_;
+    next_stamp_ = next_stamp_ == UINT32_MAX ? 1 : next_stamp_ + 1;
+
+    size_t index = home(cancel.order_id);
+    while (slots_[index].stamp != 0 && slots_[index].cancel.order_id != cancel.order_id) {
+        index = (index + 1) & mask_;
+    }
+    if (slots_[index].stamp == 0) {
+        ++size_;
+    }
+    slots_[index] = Slot{cancel, stamp};
+
+    order_[(head_ + count_) & (order_.size() - 1)] = Entry{cancel.order_id, stamp};
+    ++count_;
+    ++inserted_;
+}
+
+bool PendingCancels::take(uint64_t order_id, uint32_t sequence, uint64_t ts_event, PendingCancel& cancel) {
+    if (size_ == 0) {
+        return false;
+    }
+    expire(sequence, ts_event);
+
+    const size_t index = find(order_id);
+    if (index == SIZE_MAX) {
+        return false;
+    }
+    // expire() stops at the oldest cancel still in age; one inserted
+    // after it can be older if the feed's timestamps went backwards
+    const bool too_old = tooOld(slots_[index].cancel, sequence, ts_event);
+    cancel = slots_[index].cancel;
+    erase(index);
+    if (too_old) {
+        ++expired_;
+        return false;
+    }
+    ++matched_;
+    return true;
+}
+
+void PendingCancels::clear() {
+    // Each held cancel has an entry in order_: clear through those rather
+    // than sweeping the whole table
+    while (count_ > 0) {
+        const size_t index = popOldest();
+        if (index != SIZE_MAX) {
+            erase(index);
+        }
+    }
+    head_ = 0;
+}
@@ -0,0 +1,188 @@
+#include "Snapshot.hpp"
+#include "MBOParsed.hpp"
+#include "Timestamp.hpp"
+#include <algorithm>
+#include <cstdarg>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// printf-style append
+void appendf(std::string& out, const char* fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    const int n = std::vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n > 0) {
+        out.append(buf, std::min(static_cast<size_t>(n), sizeof(buf) - 1));
+    }
+}
+
+void captureSide(const BookSide& side, const TickSize& tick, std::vector<OrderView>& out) {
+    out.clear();
+    side.forEachLevel([&tick, &out](const PriceLevel& level) {
+        const int64_t price = tick.toPrice(level.price);
+        for (const Order* order = level.head; order; order = order->next) {
+            out.push_back(OrderView{order->order_id, order->timestamp, price, order->qty});
+        }
+    });
+}
+
+// One side of the book as a JSON array body
+void appendSideJSON(const std::vector<OrderView>& orders, unsigned decimals, std::string& out) {
+    char timestamp[48];
+    char price[32];
+
+    for (size_t i = 0; i < orders.size(); ++i) {
+        const OrderView& order = orders[i];
+        if (i > 0) {
+            out += ",\n";
+        }
+        formatTimestampNs(order.timestamp, timestamp, sizeof(timestamp));
+        formatPrice(order.price, decimals, price, sizeof(price));
+        appendf(out,
+                "    {\n"
+                "      \"order_id\": %llu,\n"
+                "      \"timestamp\": \"%s\",\n"
+                "      \"price\": %s,\n"
+                "      \"quantity\": %u\n"
+                "    }",
+                static_cast<unsigned long long>(order.order_id), timestamp,
+                price, order.qty);
+    }
+    if (!orders.empty()) {
+        out += "\n";
+    }
+}
+
+// One aggregated level as a JSON object
+void appendLevelJSON(const BookLevel& level, unsigned decimals, std::string& out) {
+    if (level.orders == 0) {
+        out += "null";
+        return;
+    }
+    char price[32];
+    formatPrice(level.price, decimals, price, sizeof(price));
+    appendf(out, "{ \"price\": %s, \"quantity\": %llu, \"orders\": %u }",
+            price, static_cast<unsigned long long>(level.qty), level.orders);
+}
+
+BookLevel fixedLevel(const BookLevel& level, const TickSize& tick) {
+    return BookLevel{tick.toPrice(level.price), level.qty, level.orders};
+}
+
+} // namespace
+
+void captureBook(const MBOBook& book, const TickSize& tick, BookView& view) {
+    const TopOfBook top = book.topOfBook();
+    view.price_decimals = tick.decimals;
+    view.top = TopOfBook{fixedLevel(top.bid, tick), fixedLevel(top.ask, tick)};
+    captureSide(book.bids(), tick, view.bids);
+    captureSide(book.asks(), tick, view.asks);
+}
+
+void appendSnapshotJSON(const BookView& view, std::string& out) {
+    appendf(out, "{\n  \"instrument_id\": %u,\n", view.instrument_id);
+    out += "  \"symbol\": \"";
+    out += view.symbol;
+    appendf(out, "\",\n  \"sequence\": %u,\n", view.sequence);
+
+    out += "  \"best_bid\": ";
+    appendLevelJSON(view.top.bid, view.price_decimals, out);
+    out += ",\n  \"best_ask\": ";
+    appendLevelJSON(view.top.ask, view.price_decimals, out);
+    out += ",\n";
+
+    // Bids: highest price first
+    out += "  \"bids\": [\n";
+    appendSideJSON(view.bids, view.price_decimals, out);
+    out += "  ],\n";
+
+    // Asks: lowest price first
+    out += "  \"asks\": [\n";
+    appendSideJSON(view.asks, view.price_decimals, out);
+    out += "  ]\n}\n";
+}
+
+bool SnapshotPolicy::parse(const std::string& spec, SnapshotPolicy& out) {
+    try {
+        if (spec == "off") {
+            out.mode = SnapshotMode::Off;
+            return true;
+        }
+        if (spec == "top") {
+            out.mode = SnapshotMode::OnTopChange;
+            return true;
+        }
+        if (spec.compare(0, 6, "every:") == 0) {
+            out.mode = SnapshotMode::EveryN;
+            out.every_n = std::stoull(spec.substr(6));
+            return out.every_n > 0;
+        }
+        if (spec.compare(0, 9, "interval:") == 0) {
+            out.mode = SnapshotMode::Interval;
+            out.interval_us = std::stoull(spec.substr(9));
+            return true;
+        }
+    } catch (const std::exception&) {
+    }
+    return false;
+}
+
+StreamSnapshotSink::StreamSnapshotSink(FILE* file, size_t buffer_size)
+    : file_(file), buffer_(buffer_size), used_(0) {
+}
+
+StreamSnapshotSink::~StreamSnapshotSink() {
+    flush();
+    if (file_ != stdout) {
+        fclose(file_);
+    }
+}
+
+void StreamSnapshotSink::write(const char* data, size_t len) {
+    if (used_ + len > buffer_.size()) {
+        drain();
+    }
+    // Oversized writes skip the buffer
+    if (len > buffer_.size()) {
+        fwrite(data, 1, len, file_);
+        return;
+    }
+    std::memcpy(buffer_.data() + used_, data, len);
+    used_ += len;
+}
+
+void StreamSnapshotSink::flush() {
+    drain();
+    fflush(file_);
+}
+
+void StreamSnapshotSink::drain() {
+    if (used_ > 0) {
+        fwrite(buffer_.data(), 1, used_, file_);
+        used_ = 0;
+    }
+}
+
+std::unique_ptr<SnapshotSink> makeSnapshotSink(const std::string& spec) {
+    if (spec == "none") {
+        return std::make_unique<NullSnapshotSink>();
+    }
+    if (spec == "stdout") {
+        return std::make_unique<StreamSnapshotSink>(stdout, kSnapshotSinkBufferSize);
+    }
+    if (spec.compare(0, 5, "file:") == 0) {
+        const std::string path = spec.substr(5);
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) {
+            std::cerr << "Error opening snapshot file: " << path << std::endl;
+            return nullptr;
+        }
+        return std::make_unique<StreamSnapshotSink>(file, kSnapshotSinkBufferSize);
+    }
+    std::cerr << "Unknown snapshot sink: " << spec << std::endl;
+    return nullptr;
+}
@@ -0,0 +1,125 @@
+#include "SnapshotWriter.hpp"
+#include <chrono>
+
+// Orders per side each view slot is sized for up front
+constexpr size_t kViewReserveOrders = 4096;
+
+SnapshotWriter::SnapshotWriter(size_t slots)
+    : views_(slots), free_(slots), ready_(slots), running_(false),
+      max_depth_(0), written_(0), coalesced_(0), dropped_(0) {
+    for (size_t i = 0; i < views_.size(); ++i) {
+        views_[i].bids.reserve(kViewReserveOrders);
+        views_[i].asks.reserve(kViewReserveOrders);
+        free_.tryPush(static_cast<uint32_t>(i));
+    }
+    buffer_.reserve(kSnapshotSinkBufferSize);
+    pending_.reserve(slots);
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    stop();
+}
+
+void SnapshotWriter::start() {
+    if (running()) {
+        return;
+    }
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&SnapshotWriter::run, this);
+}
+
+void SnapshotWriter::stop() {
+    running_.store(false, std::memory_order_release);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+BookView* SnapshotWriter::acquire() {
+    if (!running()) {
+        return nullptr;
+    }
+    uint32_t index;
+    if (!free_.tryPop(index)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return &views_[index];
+}
+
+void SnapshotWriter::publish(BookView* view) {
+    // Can't fail: there are as many ring entries as slots
+    ready_.tryPush(static_cast<uint32_t>(view - views_.data()));
+
+    const size_t depth = ready_.size();
+    if (depth > max_depth_.load(std::memory_order_relaxed)) {
+        max_depth_.store(depth, std::memory_order_relaxed);
+    }
+}
+
+void SnapshotWriter::run() {
+    auto last_flush = std::chrono::steady_clock::now();
+
+    // Keep going after stop() until the queue is empty
+    while (running() || !ready_.empty()) {
+        // Behind: of each instrument's queued views only the newest is
+        // worth writing. A shard's books share the writer, so one busy
+        // instrument mustn't crowd out the others.
+        uint32_t index;
+        while (ready_.tryPop(index)) {
+            bool replaced = false;
+            for (uint32_t& queued : pending_) {
+                if (views_[queued].instrument_id == views_[index].instrument_id) {
+                    free_.tryPush(queued);
+                    coalesced_.fetch_add(1, std::memory_order_relaxed);
+                    queued = index;
+                    replaced = true;
+                    break;
+                }
+            }
+            if (!replaced) {
+                pending_.push_back(index);
+            }
+        }
+
+        if (pending_.empty()) {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+        for (uint32_t queued : pending_) {
+            write(views_[queued]);
+            free_.tryPush(queued);
+            written_.fetch_add(1, std::memory_order_relaxed);
+        }
+        pending_.clear();
+
+        // Sinks batch writes; hand them to the OS about once a second
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_flush >= std::chrono::seconds(1)) {
+            flushSinks();
+            last_flush = now;
+        }
+    }
+    flushSinks();
+}
+
+void SnapshotWriter::flushSinks() {
+    for (auto& sink : sinks_) {
+        sink->flush();
+    }
+}
+
+void SnapshotWriter::printStats(std::ostream& out) const {
+    out << "Snapshots written: " << written()
+        << ", coalesced: " << coalesced()
+        << ", dropped: " << dropped()
+        << ", max queue depth: " << maxQueueDepth() << "/" << slots() << std::endl;
+}
+
+void SnapshotWriter::write(const BookView& view) {
+    // Reuse the buffer's capacity so steady-state snapshots don't allocate
+    buffer_.clear();
+    appendSnapshotJSON(view, buffer_);
+    for (auto& sink : sinks_) {
+        sink->write(buffer_.data(), buffer_.size());
+    }
+}
@@ -1,10 +1,187 @@
+#include <chrono>
+#include <csignal>
 #include <iostream>
+#include <string>
 #include "MBOSubscriber.hpp"
 
-int main() {
+void handleSignal(int) {
+    MBOSubscriber::requestStop();
+}
+
+void printUsage(const char* prog) {
+    std::cout << "Usage: " << prog << " [options]\n"
+              << "  --snapshot SPEC   off | top | every:N | interval:MICROS (default: top)\n"
+              << "  --sink SPEC       file:PATH | stdout | none, repeatable; with several\n"
+              << "                    shards each writes PATH with a .shardK suffix\n"
+              << "                    (default: stdout and file:orderbook_snapshots.json)\n"
+              << "  --journal PATH    append a binary snapshot/delta journal (read with journal_reader)\n"
+              << "  --journal-snapshot-every N\n"
+              << "                    messages of an instrument between its journal snapshots (default: "
+              << kDefaultJournalSnapshotEvery << ")\n"
+              << "  --instruments LIST\n"
+              << "                    only subscribe to these instrument_ids and/or symbols,\n"
+              << "                    comma-separated (default: all)\n"
+              << "  --definitions PATH\n"
+              << "                    instrument tick sizes (e.g. instruments.csv); books keep\n"
+              << "                    prices in ticks (default: DBN's 1e-9 grid)\n"
+              << "  --book-layout L   sorted | ladder: price levels in a sorted array, or a\n"
+              << "                    tick-indexed window around the touch (needs --definitions)\n"
+              << "                    (default: sorted)\n"
+              << "  --apply-fills     reduce resting orders on F fills; leave off for CME data,\n"
+              << "                    which follows each fill with its own cancel or modify\n"
+              << "  --batched         read batched samples (publisher run with --batch)\n"
+              << "  --shards N        book threads; instruments are hashed across them (default: 1)\n"
+              << "  --book-cpu N      pin shard k's book thread to core N+k\n"
+              << "  --max-orders N    orders each book is pre-sized for (default: "
+              << kDefaultMaxOrders << ")\n"
+              << "  --max-pending-cancels N\n"
+              << "                    out-of-order cancels each book holds; the oldest is evicted\n"
+              << "                    beyond that (default: " << kDefaultMaxPendingCancels << ")\n"
+              << "  --pending-cancel-age MS\n"
+              << "                    exchange time an unmatched cancel is held, 0 = no limit\n"
+              << "                    (default: " << PendingCancelAge().max_age_ns / 1000000 << ")\n"
+              << "  --pending-cancel-seqs N\n"
+              << "                    feed sequence numbers an unmatched cancel is held, 0 = no\n"
+              << "                    limit (default: " << PendingCancelAge().max_age_sequences << ")\n"
+              << "  --ring-size N     ingest ring capacity per shard in samples (default: "
+              << kDefaultIngestRingSize << ")\n"
+              << "  --busy-poll       book thread never backs off when idle\n"
+              << "  --reorder-window N\n"
+              << "                    records per instrument held past a gap (default: "
+              << kDefaultReorderCapacity << ")\n"
+              << "  --gap-timeout US  wait for a late record before asking for a resend (default: "
+              << SequencerConfig().gap_timeout.count() << ")\n"
+              << "  --recovery-timeout US\n"
+              << "                    wait for a resend before asking again (default: "
+              << SequencerConfig().recovery_timeout.count() << ")\n"
+              << "  --recovery-attempts N\n"
+              << "                    resends asked for before a gap is skipped and the book\n"
+              << "                    flagged diverged (default: " << SequencerConfig().max_recovery_attempts << ")\n"
+              << "  --stats-interval S\n"
+              << "                    print ingest stats and latency percentiles (receive,\n"
+              << "                    parse, apply; publisher on the same host) to stderr\n"
+              << "                    every S seconds\n"
+              << "  --stats-name NAME live counters in /dev/shm/mbo_stats.NAME, read with mbo_stat;\n"
+              << "                    none = don't publish them (default: " << kSubscriberStatsName << ")\n";
+}
+
+int main(int argc, char** argv) {
+    SubscriberConfig config;
+    config.registry.snapshot_policy.mode = SnapshotMode::OnTopChange;
+    bool default_sinks = true;
+    
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--snapshot" && i + 1 < argc) {
+            if (!SnapshotPolicy::parse(argv[++i], config.registry.snapshot_policy)) {
+                std::cerr << "Invalid snapshot policy: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--sink" && i + 1 < argc) {
+            if (default_sinks) {
+                config.registry.snapshot_sinks.clear();
+                default_sinks = false;
+            }
+            config.registry.snapshot_sinks.push_back(argv[++i]);
+        } else if (arg == "--journal" && i + 1 < argc) {
+            config.registry.journal_path = argv[++i];
+        } else if (arg == "--journal-snapshot-every" && i + 1 < argc) {
+            config.registry.journal_snapshot_every = std::stoull(argv[++i]);
+            if (config.registry.journal_snapshot_every == 0) {
+                std::cerr << "Invalid journal snapshot interval: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--instruments" && i + 1 < argc) {
+            config.instruments = argv[++i];
+            MBOInstrumentFilter filter;
+            if (!filter.parse(config.instruments.c_str())) {
+                std::cerr << "Invalid instrument list: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--definitions" && i + 1 < argc) {
+            if (!config.registry.instruments.load(argv[++i])) {
+                return 1;
+            }
+        } else if (arg == "--book-layout" && i + 1 < argc) {
+            const std::string layout = argv[++i];
+            if (layout == "sorted") {
+                config.registry.layout = BookLayout::Sorted;
+            } else if (layout == "ladder") {
+                config.registry.layout = BookLayout::Ladder;
+            } else {
+                std::cerr << "Invalid book layout: " << layout << std::endl;
+                return 1;
+            }
+        } else if (arg == "--apply-fills") {
+            config.registry.apply_fills = true;
+        } else if (arg == "--batched") {
+            config.batched = true;
+        } else if (arg == "--shards" && i + 1 < argc) {
+            config.registry.shards = std::stoull(argv[++i]);
+            if (config.registry.shards == 0) {
+                std::cerr << "Invalid shard count: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--max-orders" && i + 1 < argc) {
+            config.registry.max_orders = std::stoull(argv[++i]);
+        } else if (arg == "--max-pending-cancels" && i + 1 < argc) {
+            config.registry.max_pending_cancels = std::stoull(argv[++i]);
+            if (config.registry.max_pending_cancels == 0) {
+                std::cerr << "Invalid pending cancel capacity: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--pending-cancel-age" && i + 1 < argc) {
+            config.registry.pending_cancel_age.max_age_ns = std::stoull(argv[++i]) * 1000000;
+        } else if (arg == "--pending-cancel-seqs" && i + 1 < argc) {
+            config.registry.pending_cancel_age.max_age_sequences = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--book-cpu" && i + 1 < argc) {
+            config.registry.worker.cpu = std::stoi(argv[++i]);
+        } else if (arg == "--ring-size" && i + 1 < argc) {
+            config.registry.worker.ring_size = std::stoull(argv[++i]);
+        } else if (arg == "--busy-poll") {
+            config.registry.worker.busy_poll = true;
+        } else if (arg == "--reorder-window" && i + 1 < argc) {
+            config.registry.sequencer.reorder_capacity = std::stoull(argv[++i]);
+            if (config.registry.sequencer.reorder_capacity == 0) {
+                std::cerr << "Invalid reorder window: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--gap-timeout" && i + 1 < argc) {
+            config.registry.sequencer.gap_timeout = std::chrono::microseconds(std::stoull(argv[++i]));
+        } else if (arg == "--recovery-timeout" && i + 1 < argc) {
+            config.registry.sequencer.recovery_timeout = std::chrono::microseconds(std::stoull(argv[++i]));
+        } else if (arg == "--recovery-attempts" && i + 1 < argc) {
+            config.registry.sequencer.max_recovery_attempts = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--stats-interval" && i + 1 < argc) {
+            config.stats_interval_s = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--stats-name" && i + 1 < argc) {
+            config.stats_name = argv[++i];
+            if (config.stats_name == "none") {
+                config.stats_name.clear();
+            } else if (config.stats_name.empty() || config.stats_name.find('/') != std::string::npos) {
+                std::cerr << "Invalid stats segment name: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (default_sinks) {
+        config.registry.snapshot_sinks = {"stdout", "file:orderbook_snapshots.json"};
+    }
+    
     std::cout << "=== MBO Order Book Subscriber ===" << std::endl;
     
-    MBOSubscriber subscriber;
+    // Ctrl+C stops run() so the book drains and outputs are closed cleanly
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    
+    MBOSubscriber subscriber(config);
     
     if (!subscriber.init()) {
         std::cerr << "Failed to initialize subscriber" << std::endl;
@@ -21,4 +198,4 @@ int main() {
     }
     
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,295 @@
+// Prints the live counters a running recon_orderbook or data_streaming keeps
+// in its stats segment, vmstat style: a row every DELAY seconds, the first
+// one covering the time since the service started. Rates are per second,
+// counts are for the row's interval, and latencies are percentiles over
+// the interval in microseconds since the publisher's send stamp. The
+// segment is only mapped read-only, so the service doesn't notice.
+//
+//   mbo_stat [NAME] [DELAY [COUNT]]     NAME defaults to recon_orderbook
+//   mbo_stat -l                         list the segments in /dev/shm
+
+#include "StatsSegment.hpp"
+#include "Timestamp.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <dirent.h>
+#include <iomanip>
+#include <iostream>
+#include <signal.h>
+#include <string>
+#include <thread>
+
+namespace {
+
+// Rows between repeats of the column headings
+constexpr unsigned kHeaderEvery = 20;
+
+// Segment file names are this plus the service's stats name
+constexpr const char* kSegmentPrefix = "mbo_stats.";
+
+void printUsage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [NAME] [DELAY [COUNT]]\n"
+              << "       " << argv0 << " -l\n"
+              << "  NAME   stats segment (default: " << kSubscriberStatsName << "; the publisher's is "
+              << kPublisherStatsName << ")\n"
+              << "  DELAY  seconds between rows (default: 1)\n"
+              << "  COUNT  rows to print (default: until the service exits)\n"
+              << "  -l     list the stats segments in /dev/shm\n";
+}
+
+bool alive(const StatsHeader& header) {
+    return kill(static_cast<pid_t>(header.pid), 0) == 0 || errno != ESRCH;
+}
+
+const char* serviceName(StatsService service) {
+    switch (service) {
+        case StatsService::Publisher:  return "publisher";
+        case StatsService::Subscriber: return "subscriber";
+    }
+    return "unknown";
+}
+
+// Everything one row is computed from, read at one instant
+struct Sample {
+    uint64_t ns = 0;
+
+    // Publisher
+    uint64_t records_in = 0;
+    uint64_t parse_errors = 0;
+    uint64_t records_out = 0;
+    uint64_t samples_out = 0;
+    uint64_t instruments = 0;
+    uint64_t records_resent = 0;
+    uint64_t recovery_requests = 0;
+
+    // Subscriber, summed over the shards
+    uint64_t samples_in = 0;
+    uint64_t malformed = 0;
+    uint64_t dropped = 0;
+    uint64_t records = 0;
+    uint64_t books = 0;
+    uint64_t live_orders = 0;
+    uint64_t bid_levels = 0;
+    uint64_t ask_levels = 0;
+    uint64_t pending_cancels = 0;
+    uint64_t ring_depth = 0;        // deepest ring
+    uint64_t gaps = 0;
+    uint64_t snapshots_out = 0;
+    LatencyHistogram received;
+    LatencyHistogram applied;
+
+    uint64_t actions[kStatsActions] = {};
+};
+
+void read(const StatsSegment& segment, Sample& sample) {
+    sample.ns = monotonicNowNs();
+    const StatsHeader& header = segment.header();
+    if (header.service == StatsService::Publisher) {
+        const PublisherStats& stats = segment.publisher();
+        sample.records_in = stats.records_in.get();
+        sample.parse_errors = stats.parse_errors.get();
+        sample.records_out = stats.records_out.get();
+        sample.samples_out = stats.samples_out.get();
+        sample.instruments = stats.instruments.get();
+        sample.records_resent = stats.records_resent.get();
+        sample.recovery_requests = stats.recovery_requests.get();
+        for (size_t i = 0; i < kStatsActions; ++i) {
+            sample.actions[i] = stats.actions[i].get();
+        }
+        return;
+    }
+
+    const DispatchStats& dispatch = segment.dispatch();
+    sample.samples_in = dispatch.samples_in.get();
+    sample.malformed = dispatch.malformed.get();
+    sample.dropped = dispatch.dropped.get();
+    dispatch.received.snapshot(sample.received);
+
+    sample.records = sample.books = sample.live_orders = sample.bid_levels = sample.ask_levels = 0;
+    sample.pending_cancels = sample.ring_depth = sample.gaps = sample.snapshots_out = 0;
+    for (size_t i = 0; i < kStatsActions; ++i) {
+        sample.actions[i] = 0;
+    }
+    sample.applied.reset();
+    LatencyHistogram shard_applied;
+    for (size_t s = 0; s < header.shards; ++s) {
+        const ShardStats& shard = segment.shard(s);
+        sample.records += shard.records.get();
+        for (size_t i = 0; i < kStatsActions; ++i) {
+            sample.actions[i] += shard.actions[i].get();
+        }
+        sample.books += shard.books.get();
+        sample.live_orders += shard.live_orders.get();
+        sample.bid_levels += shard.bid_levels.get();
+        sample.ask_levels += shard.ask_levels.get();
+        sample.pending_cancels += shard.pending_cancels.get();
+        sample.ring_depth = std::max(sample.ring_depth, shard.ring_depth.get());
+        sample.gaps += shard.gaps.get();
+        sample.snapshots_out += shard.snapshots_out.get();
+        shard.applied.snapshot(shard_applied);
+        sample.applied.merge(shard_applied);
+    }
+}
+
+void printHeader(StatsService service) {
+    if (service == StatsService::Publisher) {
+        std::cout << "    in/s   out/s  smpl/s   add/s   cxl/s   mod/s  fill/s   trd/s   err  instr  resent   req"
+                  << std::endl;
+    } else {
+        std::cout << "    in/s  drop   apply/s   add/s   cxl/s   mod/s  fill/s   trd/s   bad  books  orders  bidlv"
+                  << "  asklv   pend   ring  gaps  snap/s  recv50  recv99  tick50  tick99 tick999 tickmax"
+                  << std::endl;
+    }
+}
+
+// Interval percentile in microseconds, "-" without samples
+void printLatency(double ns, bool any) {
+    if (any) {
+        std::cout << std::setw(8) << std::fixed << std::setprecision(1) << ns / 1000.0;
+    } else {
+        std::cout << std::setw(8) << "-";
+    }
+}
+
+void printRow(StatsService service, const Sample& now, const Sample& then) {
+    const double secs = static_cast<double>(now.ns > then.ns ? now.ns - then.ns : 1) / 1e9;
+    auto rate = [secs](uint64_t a, uint64_t b) { return static_cast<uint64_t>(static_cast<double>(a - b) / secs + 0.5); };
+
+    if (service == StatsService::Publisher) {
+        std::cout << std::setw(8) << rate(now.records_in, then.records_in)
+                  << std::setw(8) << rate(now.records_out, then.records_out)
+                  << std::setw(8) << rate(now.samples_out, then.samples_out);
+        for (size_t i = kStatsAdd; i <= kStatsTrade; ++i) {
+            std::cout << std::setw(8) << rate(now.actions[i], then.actions[i]);
+        }
+        std::cout << std::setw(6) << now.parse_errors - then.parse_errors
+                  << std::setw(7) << now.instruments
+                  << std::setw(8) << now.records_resent - then.records_resent
+                  << std::setw(6) << now.recovery_requests - then.recovery_requests << std::endl;
+        return;
+    }
+
+    LatencyHistogram received = now.received;
+    received.subtract(then.received);
+    LatencyHistogram applied = now.applied;
+    applied.subtract(then.applied);
+
+    std::cout << std::setw(8) << rate(now.samples_in, then.samples_in)
+              << std::setw(6) << now.dropped - then.dropped
+              << std::setw(10) << rate(now.records, then.records);
+    for (size_t i = kStatsAdd; i <= kStatsTrade; ++i) {
+        std::cout << std::setw(8) << rate(now.actions[i], then.actions[i]);
+    }
+    std::cout << std::setw(6) << (now.actions[kStatsOther] - then.actions[kStatsOther]) + (now.malformed - then.malformed)
+              << std::setw(7) << now.books
+              << std::setw(8) << now.live_orders
+              << std::setw(7) << now.bid_levels
+              << std::setw(7) << now.ask_levels
+              << std::setw(7) << now.pending_cancels
+              << std::setw(7) << now.ring_depth
+              << std::setw(6) << now.gaps - then.gaps
+              << std::setw(8) << rate(now.snapshots_out, then.snapshots_out);
+    printLatency(static_cast<double>(received.percentile(0.50)), received.count() > 0);
+    printLatency(static_cast<double>(received.percentile(0.99)), received.count() > 0);
+    printLatency(static_cast<double>(applied.percentile(0.50)), applied.count() > 0);
+    printLatency(static_cast<double>(applied.percentile(0.99)), applied.count() > 0);
+    printLatency(static_cast<double>(applied.percentile(0.999)), applied.count() > 0);
+    printLatency(static_cast<double>(applied.max()), applied.count() > 0);
+    std::cout << std::endl;
+}
+
+int list() {
+    DIR* dir = opendir("/dev/shm");
+    if (!dir) {
+        std::cerr << "Failed to open /dev/shm" << std::endl;
+        return 1;
+    }
+    const std::string prefix = kSegmentPrefix;
+    while (const dirent* entry = readdir(dir)) {
+        const std::string file = entry->d_name;
+        if (file.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        StatsSegment segment;
+        if (!segment.open(file.substr(prefix.size()))) {
+            continue;
+        }
+        const StatsHeader& header = segment.header();
+        const uint64_t now_ns = monotonicNowNs();
+        std::cout << std::left << std::setw(20) << file.substr(prefix.size()) << std::right
+                  << " " << serviceName(header.service) << ", pid " << header.pid
+                  << (alive(header) ? "" : " (exited)");
+        if (header.service == StatsService::Subscriber) {
+            std::cout << ", " << header.shards << " shards";
+        }
+        std::cout << ", up " << (now_ns > header.started_ns ? (now_ns - header.started_ns) / 1000000000 : 0) << " s"
+                  << std::endl;
+    }
+    closedir(dir);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string name = kSubscriberStatsName;
+    double delay_s = 1.0;
+    uint64_t count = 0;
+
+    int arg = 1;
+    if (arg < argc && std::string(argv[arg]) == "-l") {
+        return list();
+    }
+    if (arg < argc && (std::string(argv[arg]) == "-h" || std::string(argv[arg]) == "--help")) {
+        printUsage(argv[0]);
+        return 0;
+    }
+    try {
+        if (arg < argc && !std::isdigit(static_cast<unsigned char>(argv[arg][0]))) {
+            name = argv[arg++];
+        }
+        if (arg < argc) {
+            delay_s = std::stod(argv[arg++]);
+        }
+        if (arg < argc) {
+            count = std::stoull(argv[arg++]);
+        }
+    } catch (const std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (arg < argc || delay_s <= 0.0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    StatsSegment segment;
+    if (!segment.open(name)) {
+        return 1;
+    }
+    const StatsService service = segment.header().service;
+
+    // First row: everything since the service started
+    Sample then;
+    then.ns = segment.header().started_ns;
+    Sample now;
+    for (uint64_t row = 0; count == 0 || row < count; ++row) {
+        if (row > 0) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(delay_s));
+        }
+        if (row % kHeaderEvery == 0) {
+            printHeader(service);
+        }
+        read(segment, now);
+        printRow(service, now, then);
+        std::swap(now, then);
+
+        if (!alive(segment.header())) {
+            std::cerr << name << ": service exited" << std::endl;
+            break;
+        }
+    }
+    return 0;
+}